@@ -0,0 +1,124 @@
+//
+//  aggregate_bench.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "bench.hpp"
+#include "settings.hpp"
+#include "columnar_model.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace Table;
+
+// Totals up 10M rows: the aggregate_values kernel against a plain loop,
+// then whole results grouped by a column with 100 values, where the
+// aggregates of a double column and of a column of numbers as strings
+// are computed along with the grouping or added to cached results.
+
+static const int RUNS = 3;
+
+template <typename Fn>
+static double best_seconds(Fn fn) {
+    double best = 1e9;
+    for (int run = 0; run < RUNS; ++run) {
+        Stopwatch stopwatch;
+        fn();
+        best = std::min(best, stopwatch.seconds());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    auto rows = max_rows_argument(argc, argv, 10000000);
+
+    std::mt19937 rng(24);
+    ColumnarModel model({"desk", "pnl", "quantity"}, {});
+    model.reserve(rows);
+    std::vector<std::vector<std::string>> batch;
+    for (int i = 0; i < rows; ++i) {
+        batch.push_back({
+            "desk " + std::to_string(rng() % 100),
+            (rng() % 20 == 0 ? std::string() : std::to_string((int)(rng() % 200000) - 100000) + ".25"),
+            std::to_string(rng() % 5000)
+        });
+        if (batch.size() == 65536 || i + 1 == rows) {
+            model.insert_rows(std::move(batch));
+            batch.clear();
+        }
+    }
+    model.set_column_dictionary(0, true);
+    model.set_column_type(1, Model::COLUMN_DOUBLE);
+
+    // The reduction alone, over the numbers of the double column
+    NumberCache number_cache;
+    auto& values = column_numbers(model, 1, number_cache);
+    Aggregate kernel_total, loop_total;
+    auto kernel_seconds = best_seconds([&]() {
+        kernel_total = Aggregate();
+        aggregate_values(values.data(), values.size(), kernel_total);
+    });
+    auto loop_seconds = best_seconds([&]() {
+        loop_total = Aggregate();
+        for (auto value : values) {
+            if (value == value) {
+                ++loop_total.count;
+                loop_total.sum += value;
+                loop_total.min = std::min(loop_total.min, value);
+                loop_total.max = std::max(loop_total.max, value);
+            }
+        }
+    });
+
+    Settings settings;
+    settings.column_widths.assign(3, 100);
+    settings.column_enabled.assign(3, true);
+    settings.column_ordering = {0, 1, 2};
+    ColumnFilter no_filter;
+    no_filter.enabled = false;
+    settings.filters.assign(3, no_filter);
+    settings.grouped_columns = {0};
+
+    Results results;
+    auto grouped_seconds = best_seconds([&]() {
+        ResultsCache cache;
+        update_results(model, settings, cache, results);
+    });
+
+    settings.aggregated_columns = {1, 2};
+    auto aggregated_seconds = best_seconds([&]() {
+        ResultsCache cache;
+        update_results(model, settings, cache, results);
+    });
+
+    // Adding a column to results that are already grouped only reads
+    // and totals up that column
+    double added_seconds = 1e9;
+    for (int run = 0; run < RUNS; ++run) {
+        ResultsCache cache;
+        settings.aggregated_columns = {1};
+        update_results(model, settings, cache, results);
+        settings.aggregated_columns = {1, 2};
+        Stopwatch stopwatch;
+        update_results(model, settings, cache, results);
+        added_seconds = std::min(added_seconds, stopwatch.seconds());
+    }
+
+    std::printf("%d rows, %zu groups\n", rows, results.group_headings.size());
+    std::printf("%-44s %10s\n", "", "ms");
+    std::printf("%-44s %10.1f\n", "aggregate_values over one column", kernel_seconds * 1e3);
+    std::printf("%-44s %10.1f\n", "plain loop over one column", loop_seconds * 1e3);
+    std::printf("%-44s %10.1f\n", "grouping alone", grouped_seconds * 1e3);
+    std::printf("%-44s %10.1f\n", "grouping with two aggregated columns", aggregated_seconds * 1e3);
+    std::printf("%-44s %10.1f\n", "adding a string column to cached results", added_seconds * 1e3);
+    if (kernel_total.count != loop_total.count || kernel_total.min != loop_total.min ||
+        kernel_total.max != loop_total.max) {
+        std::printf("aggregate_values and the plain loop disagree\n");
+        return 1;
+    }
+    return 0;
+}
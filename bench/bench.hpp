@@ -0,0 +1,36 @@
+//
+//  bench.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_bench_hpp
+#define ddui_table_bench_hpp
+
+#include <chrono>
+#include <cstdlib>
+
+// Benchmarks print a table of timings to stdout. Each one takes the
+// largest row count to run up to as an optional first argument, so
+// that a quick run can stay small.
+
+class Stopwatch {
+    public:
+        Stopwatch() {
+            start = std::chrono::steady_clock::now();
+        }
+        double seconds() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+};
+
+inline int max_rows_argument(int argc, char** argv, int default_rows) {
+    return argc > 1 ? std::atoi(argv[1]) : default_rows;
+}
+
+#endif
@@ -0,0 +1,95 @@
+//
+//  filter_bench.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "bench.hpp"
+#include "settings.hpp"
+#include "columnar_model.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+using namespace Table;
+
+// Filters a table on three columns (dictionary encoded, plain strings
+// and integers) with the shared WorkerPool resized from 1 thread up to
+// the number of hardware threads, and checks that every pool size gives
+// the same rows.
+
+static const int RUNS = 3;
+
+static void allow(Settings& settings, int j, const std::string& prefix, int count) {
+    settings.filters[j].enabled = true;
+    for (int v = 0; v < count; ++v) {
+        settings.filters[j].allowed_values[prefix + std::to_string(v)] = true;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto rows = max_rows_argument(argc, argv, 5000000);
+
+    std::mt19937 rng(17);
+    ColumnarModel model({"category", "region", "quantity", "note"}, {});
+    model.reserve(rows);
+    std::vector<std::vector<std::string>> batch;
+    for (int i = 0; i < rows; ++i) {
+        batch.push_back({
+            "category " + std::to_string(rng() % 50),
+            "region " + std::to_string(rng() % 20),
+            std::to_string(rng() % 1000),
+            "note " + std::to_string(i)
+        });
+        if (batch.size() == 65536 || i + 1 == rows) {
+            model.insert_rows(std::move(batch));
+            batch.clear();
+        }
+    }
+    model.set_column_dictionary(0, true);
+    model.set_column_type(2, Model::COLUMN_INT64);
+
+    Settings settings;
+    settings.column_widths.assign(4, 100);
+    settings.column_enabled.assign(4, true);
+    settings.column_ordering = {0, 1, 2, 3};
+    ColumnFilter no_filter;
+    no_filter.enabled = false;
+    settings.filters.assign(4, no_filter);
+    allow(settings, 0, "category ", 25);
+    allow(settings, 1, "region ", 10);
+    allow(settings, 2, "", 500);
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> pool_sizes;
+    for (int size = 1; size < max_threads; size *= 2) {
+        pool_sizes.push_back(size);
+    }
+    pool_sizes.push_back(max_threads);
+
+    std::printf("%d rows\n%8s %10s %8s %10s\n", rows, "threads", "ms", "speedup", "same rows");
+    std::vector<int> serial_rows;
+    double serial_seconds = 0;
+    for (auto size : pool_sizes) {
+        WorkerPool::set_shared_size(size);
+        double best = 1e9;
+        Results results;
+        for (int run = 0; run < RUNS; ++run) {
+            ResultsCache cache;
+            Stopwatch stopwatch;
+            update_results(model, settings, cache, results);
+            best = std::min(best, stopwatch.seconds());
+        }
+        if (size == 1) {
+            serial_rows = results.row_indices;
+            serial_seconds = best;
+        }
+        std::printf("%8d %10.1f %8.2f %10s\n", size, best * 1e3, serial_seconds / best,
+                    results.row_indices == serial_rows ? "yes" : "NO");
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+//
+//  import_bench.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "bench.hpp"
+#include "import_csv_to_table.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <sstream>
+
+using namespace Table;
+
+// Throughput of each stage of importing CSV, in MB/s, over CSV held in
+// memory so that the disk doesn't decide the numbers. A std::getline
+// loop, which only finds the lines, is the baseline.
+
+static const int RUNS = 3;
+
+// CSV as export_table_to_csv() writes it, with some quoted fields that
+// hold commas, quotes and backslashes
+static std::string make_csv(int rows) {
+    std::mt19937 rng(13);
+    std::string csv = "id,name,price,time,note\n";
+    for (int i = 0; i < rows; ++i) {
+        csv += std::to_string(i);
+        csv += ",name ";
+        csv += std::to_string(rng() % 1000);
+        csv += ',';
+        csv += std::to_string(rng() % 100000) + "." + std::to_string(rng() % 100);
+        csv += ",2026-10-17 12:";
+        csv += std::to_string(10 + rng() % 50) + ":" + std::to_string(10 + rng() % 50);
+        csv += (rng() % 4 == 0 ? ",\"a note, with \\\"quotes\\\" and a \\\\\"\n" : ",plain note\n");
+    }
+    return csv;
+}
+
+template <typename Fn>
+static double best_seconds(Fn fn) {
+    double best = 1e9;
+    for (int run = 0; run < RUNS; ++run) {
+        Stopwatch stopwatch;
+        fn();
+        best = std::min(best, stopwatch.seconds());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    auto rows = max_rows_argument(argc, argv, 2000000);
+    auto csv = make_csv(rows);
+    auto megabytes = csv.size() / 1e6;
+    std::printf("%d rows, %.1f MB\n", rows, megabytes);
+
+    size_t lines = 0;
+    auto getline_seconds = best_seconds([&]() {
+        std::istringstream in(csv);
+        std::string line;
+        lines = 0;
+        while (std::getline(in, line)) {
+            ++lines;
+        }
+    });
+
+    auto scan_seconds = best_seconds([&]() {
+        CsvLineScanner scanner(csv.data(), csv.size(), true);
+        std::vector<size_t> fields;
+        lines = 0;
+        while (scanner.next_line(fields)) {
+            ++lines;
+        }
+    });
+
+    auto read_seconds = best_seconds([&]() {
+        std::istringstream in(csv);
+        CsvImporter importer(in);
+        std::vector<std::vector<std::string>> batch;
+        while (importer.read_rows(batch)) {
+        }
+    });
+
+    auto basic_seconds = best_seconds([&]() {
+        std::istringstream in(csv);
+        CsvImporter importer(in);
+        BasicModel model(importer.headers(), {});
+        import_csv_to_table(importer, model);
+    });
+
+    auto columnar_seconds = best_seconds([&]() {
+        std::istringstream in(csv);
+        CsvImporter importer(in);
+        ColumnarModel model(importer.headers(), {});
+        import_csv_to_table(importer, model);
+    });
+
+    std::printf("%-36s %8s\n", "stage", "MB/s");
+    std::printf("%-36s %8.0f\n", "std::getline lines (baseline)", megabytes / getline_seconds);
+    std::printf("%-36s %8.0f\n", "CsvLineScanner lines and fields", megabytes / scan_seconds);
+    std::printf("%-36s %8.0f\n", "CsvImporter rows", megabytes / read_seconds);
+    std::printf("%-36s %8.0f\n", "import_csv_to_table, BasicModel", megabytes / basic_seconds);
+    std::printf("%-36s %8.0f\n", "import_csv_to_table, ColumnarModel", megabytes / columnar_seconds);
+    return 0;
+}
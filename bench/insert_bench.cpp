@@ -0,0 +1,82 @@
+//
+//  insert_bench.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "bench.hpp"
+#include "model.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace Table;
+
+// Upserts a batch of keyed rows into BasicModels that already hold more
+// and more rows, half of them replacing existing rows and half adding
+// new ones. With the key index, the cost per row stays flat as the
+// table grows.
+
+static const int UPSERTS = 50000;
+static const int RUNS = 3;
+
+static std::vector<std::string> make_row(int id, std::mt19937& rng) {
+    return {
+        "id" + std::to_string(id),
+        "name " + std::to_string(rng() % 1000),
+        std::to_string(rng() % 100000)
+    };
+}
+
+static BasicModel make_model(int rows, std::mt19937& rng) {
+    BasicModel model({"id", "name", "value"}, {"id"});
+    std::vector<std::vector<std::string>> batch;
+    for (int i = 0; i < rows; ++i) {
+        batch.push_back(make_row(i, rng));
+    }
+    model.insert_rows(std::move(batch));
+    return model;
+}
+
+static std::vector<std::vector<std::string>> make_upserts(int rows, std::mt19937& rng) {
+    std::vector<std::vector<std::string>> upserts;
+    for (int k = 0; k < UPSERTS; ++k) {
+        auto id = (k % 2 == 0 ? (int)(rng() % rows) : rows + k);
+        upserts.push_back(make_row(id, rng));
+    }
+    return upserts;
+}
+
+int main(int argc, char** argv) {
+    auto max_rows = max_rows_argument(argc, argv, 1000000);
+    std::mt19937 rng(1);
+
+    std::printf("%10s %18s %18s\n", "rows", "insert_row us/row", "upsert_rows us/row");
+    for (int rows = 10000; rows <= max_rows; rows *= 10) {
+        for (auto size : {rows, rows * 5}) {
+            if (size > max_rows) {
+                continue;
+            }
+            double one_by_one = 1e9, batched = 1e9;
+            for (int run = 0; run < RUNS; ++run) {
+                auto upserts = make_upserts(size, rng);
+
+                auto model = make_model(size, rng);
+                Stopwatch stopwatch;
+                for (auto& row : upserts) {
+                    model.insert_row(row);
+                }
+                one_by_one = std::min(one_by_one, stopwatch.seconds());
+
+                model = make_model(size, rng);
+                stopwatch = Stopwatch();
+                model.upsert_rows(std::move(upserts));
+                batched = std::min(batched, stopwatch.seconds());
+            }
+            std::printf("%10d %18.3f %18.3f\n", size, one_by_one * 1e6 / UPSERTS, batched * 1e6 / UPSERTS);
+        }
+    }
+    return 0;
+}
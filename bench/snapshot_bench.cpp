@@ -0,0 +1,81 @@
+//
+//  snapshot_bench.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "bench.hpp"
+#include "snapshot_model.hpp"
+#include "columnar_model.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace Table;
+
+// Saves ColumnarModels of 100k to 10M rows (a string, a dictionary, a
+// double and a timestamp column) as snapshots, then times opening each
+// snapshot and a first scan of every cell of its string column. Opening
+// only reads the headers and dictionaries, so it should stay flat as
+// the rows grow. The file was just written, so the scan mostly maps
+// pages the OS still has cached rather than reading the disk.
+
+static const char* PATH = "snapshot_bench.snap";
+
+int main(int argc, char** argv) {
+    auto max_rows = max_rows_argument(argc, argv, 10000000);
+
+    std::printf("%10s %10s %10s %10s %12s\n", "rows", "MB", "save ms", "open ms", "scan ms");
+    for (int rows = 100000; rows <= max_rows; rows *= 10) {
+        std::mt19937 rng(14);
+        ColumnarModel model({"name", "desk", "price", "time"}, {});
+        model.reserve(rows);
+        std::vector<std::vector<std::string>> batch;
+        for (int i = 0; i < rows; ++i) {
+            batch.push_back({
+                "name " + std::to_string(rng() % 1000000),
+                "desk " + std::to_string(rng() % 100),
+                std::to_string(rng() % 100000) + "." + std::to_string(rng() % 100),
+                "2026-10-17 12:" + std::to_string(10 + rng() % 50) + ":" + std::to_string(10 + rng() % 50)
+            });
+            if (batch.size() == 65536 || i + 1 == rows) {
+                model.insert_rows(std::move(batch));
+                batch.clear();
+            }
+        }
+        model.set_column_dictionary(1, true);
+        model.set_column_type(2, Model::COLUMN_DOUBLE);
+        model.set_column_type(3, Model::COLUMN_TIMESTAMP);
+
+        Stopwatch stopwatch;
+        save_table_snapshot(model, PATH);
+        auto save_seconds = stopwatch.seconds();
+
+        stopwatch = Stopwatch();
+        SnapshotModel snapshot(PATH);
+        auto open_seconds = stopwatch.seconds();
+
+        // The first scan pays for mapping in the column's pages
+        stopwatch = Stopwatch();
+        size_t bytes = 0;
+        for_each_cell(snapshot, 0, [&](int i, std::string_view cell) {
+            bytes += cell.size();
+        });
+        auto scan_seconds = stopwatch.seconds();
+
+        FILE* file = std::fopen(PATH, "rb");
+        std::fseek(file, 0, SEEK_END);
+        auto megabytes = std::ftell(file) / 1e6;
+        std::fclose(file);
+
+        std::printf("%10d %10.1f %10.1f %10.3f %12.1f\n", rows, megabytes, save_seconds * 1e3,
+                    open_seconds * 1e3, scan_seconds * 1e3);
+        if (bytes == 0) {
+            return 1;
+        }
+    }
+    std::remove(PATH);
+    return 0;
+}
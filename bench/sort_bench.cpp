@@ -0,0 +1,95 @@
+//
+//  sort_bench.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "bench.hpp"
+#include "settings.hpp"
+#include "columnar_model.hpp"
+#include "alphacmp.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+using namespace Table;
+
+// Sorts 10k to 10M rows by a column of names and a column of numbers
+// (both strings), through update_results (sort keys and the radix sort)
+// and through std::sort with a std::function comparing cells with
+// alphacmp, which is how rows were sorted before.
+
+static double time_update_results(Model& model, Settings& settings, Results& results) {
+    ResultsCache cache;
+    Stopwatch stopwatch;
+    update_results(model, settings, cache, results);
+    return stopwatch.seconds();
+}
+
+static double time_std_sort(Model& model, int j, bool ascending, std::vector<int>& rows) {
+    Stopwatch stopwatch;
+    rows.resize(model.rows());
+    for (int i = 0; i < model.rows(); ++i) {
+        rows[i] = i;
+    }
+    std::function<bool(int, int)> compare;
+    if (ascending) {
+        compare = [&](int i1, int i2) {
+            return alphacmp_ascending(model.cell_text(i1, j), model.cell_text(i2, j));
+        };
+    } else {
+        compare = [&](int i1, int i2) {
+            return alphacmp_descending(model.cell_text(i1, j), model.cell_text(i2, j));
+        };
+    }
+    std::sort(rows.begin(), rows.end(), compare);
+    return stopwatch.seconds();
+}
+
+int main(int argc, char** argv) {
+    auto max_rows = max_rows_argument(argc, argv, 10000000);
+
+    std::printf("%10s %-8s %12s %12s %8s\n", "rows", "column", "std::sort ms", "radix ms", "speedup");
+    for (int rows = 10000; rows <= max_rows; rows *= 10) {
+        std::mt19937 rng(19);
+        ColumnarModel model({"name", "price"}, {});
+        model.reserve(rows);
+        std::vector<std::vector<std::string>> batch;
+        for (int i = 0; i < rows; ++i) {
+            batch.push_back({
+                "item " + std::to_string(rng() % 1000000),
+                std::to_string(rng() % 100000) + "." + std::to_string(rng() % 100)
+            });
+            if (batch.size() == 65536 || i + 1 == rows) {
+                model.insert_rows(std::move(batch));
+                batch.clear();
+            }
+        }
+
+        Settings settings;
+        settings.column_widths.assign(2, 100);
+        settings.column_enabled.assign(2, true);
+        settings.column_ordering = {0, 1};
+        ColumnFilter no_filter;
+        no_filter.enabled = false;
+        settings.filters.assign(2, no_filter);
+
+        const char* names[] = {"name", "price"};
+        for (int j = 0; j < 2; ++j) {
+            auto ascending = (j == 0);
+            settings.sort_keys = {SortKey{j, ascending}};
+
+            Results results;
+            auto radix_seconds = time_update_results(model, settings, results);
+            std::vector<int> sorted_rows;
+            auto std_sort_seconds = time_std_sort(model, j, ascending, sorted_rows);
+
+            std::printf("%10d %-8s %12.1f %12.1f %8.1f\n", rows, names[j], std_sort_seconds * 1e3,
+                        radix_seconds * 1e3, std_sort_seconds / radix_seconds);
+        }
+    }
+    return 0;
+}
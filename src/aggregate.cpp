@@ -0,0 +1,236 @@
+//
+//  aggregate.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "aggregate.hpp"
+#include "typed_value.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace Table {
+
+static constexpr size_t ROWS_PER_TASK = 1 << 16;
+static constexpr uint32_t NO_GROUP = ~(uint32_t)0;
+
+void merge_aggregate(Aggregate& aggregate, const Aggregate& other) {
+    aggregate.count += other.count;
+    aggregate.sum += other.sum;
+    aggregate.min = std::min(aggregate.min, other.min);
+    aggregate.max = std::max(aggregate.max, other.max);
+}
+
+// The vector loops rely on min and max returning their second operand
+// when the first is NaN, so NaN never makes it into the running min and
+// max. For the sum and count, NaN lanes are masked out.
+void aggregate_values(const double* values, size_t count, Aggregate& aggregate) {
+    size_t k = 0;
+    double lanes_count = 0, lanes_sum = 0;
+    double lanes_min = INFINITY, lanes_max = -INFINITY;
+
+#if defined(__AVX__)
+    auto counts = _mm256_setzero_pd();
+    auto sums = _mm256_setzero_pd();
+    auto mins = _mm256_set1_pd(INFINITY);
+    auto maxs = _mm256_set1_pd(-INFINITY);
+    auto ones = _mm256_set1_pd(1.0);
+    for (; k + 4 <= count; k += 4) {
+        auto chunk = _mm256_loadu_pd(values + k);
+        auto is_number = _mm256_cmp_pd(chunk, chunk, _CMP_ORD_Q);
+        counts = _mm256_add_pd(counts, _mm256_and_pd(is_number, ones));
+        sums = _mm256_add_pd(sums, _mm256_and_pd(is_number, chunk));
+        mins = _mm256_min_pd(chunk, mins);
+        maxs = _mm256_max_pd(chunk, maxs);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, counts);
+    lanes_count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_pd(lanes, sums);
+    lanes_sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_pd(lanes, mins);
+    lanes_min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_storeu_pd(lanes, maxs);
+    lanes_max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(__SSE2__) || defined(_M_X64)
+    auto counts = _mm_setzero_pd();
+    auto sums = _mm_setzero_pd();
+    auto mins = _mm_set1_pd(INFINITY);
+    auto maxs = _mm_set1_pd(-INFINITY);
+    auto ones = _mm_set1_pd(1.0);
+    for (; k + 2 <= count; k += 2) {
+        auto chunk = _mm_loadu_pd(values + k);
+        auto is_number = _mm_cmpord_pd(chunk, chunk);
+        counts = _mm_add_pd(counts, _mm_and_pd(is_number, ones));
+        sums = _mm_add_pd(sums, _mm_and_pd(is_number, chunk));
+        mins = _mm_min_pd(chunk, mins);
+        maxs = _mm_max_pd(chunk, maxs);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, counts);
+    lanes_count = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sums);
+    lanes_sum = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, mins);
+    lanes_min = std::min(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, maxs);
+    lanes_max = std::max(lanes[0], lanes[1]);
+#endif
+
+    for (; k < count; ++k) {
+        auto value = values[k];
+        if (value == value) {
+            lanes_count += 1;
+            lanes_sum += value;
+            lanes_min = std::min(lanes_min, value);
+            lanes_max = std::max(lanes_max, value);
+        }
+    }
+
+    aggregate.count += (int)lanes_count;
+    aggregate.sum += lanes_sum;
+    aggregate.min = std::min(aggregate.min, lanes_min);
+    aggregate.max = std::max(aggregate.max, lanes_max);
+}
+
+const std::vector<double>& column_numbers(Model& model, int j, NumberCache& number_cache) {
+    auto ref = model.ref();
+    auto num_rows = model.rows();
+
+    number_cache.columns.resize(model.columns());
+    auto& column = number_cache.columns[j];
+    if (column.ref == ref) {
+        return column.values;
+    }
+
+    // Numbers of other columns were read from an older model
+    for (auto& other : number_cache.columns) {
+        if (other.ref != ref) {
+            other = NumberCache::Column();
+        }
+    }
+    column.ref = ref;
+    auto& values = column.values;
+    values.resize(num_rows);
+
+    switch (model.column_type(j)) {
+        case Model::COLUMN_INT64:
+        case Model::COLUMN_TIMESTAMP: {
+            for (int i = 0; i < num_rows; ++i) {
+                auto value = model.cell_int64(i, j);
+                values[i] = (value == NULL_INT64 ? NAN : (double)value);
+            }
+            return values;
+        }
+        case Model::COLUMN_DOUBLE: {
+            for (int i = 0; i < num_rows; ++i) {
+                values[i] = model.cell_double(i, j);
+            }
+            return values;
+        }
+        case Model::COLUMN_STRING:
+            break;
+    }
+
+    std::string text;
+    for_each_cell(model, j, [&](int i, std::string_view cell) {
+        double value;
+        text.assign(cell.data(), cell.size());
+        values[i] = (parse_double(text, &value) ? value : NAN);
+    });
+    return values;
+}
+
+double cell_number(Model& model, int i, int j) {
+    switch (model.column_type(j)) {
+        case Model::COLUMN_INT64:
+        case Model::COLUMN_TIMESTAMP: {
+            auto value = model.cell_int64(i, j);
+            return (value == NULL_INT64 ? NAN : (double)value);
+        }
+        case Model::COLUMN_DOUBLE:
+            return model.cell_double(i, j);
+        case Model::COLUMN_STRING:
+            break;
+    }
+
+    double value;
+    return (parse_double(model.cell_text(i, j), &value) ? value : NAN);
+}
+
+void layout_groups(const std::vector<uint32_t>& row_groups, size_t num_groups, GroupLayout& layout) {
+    auto& begin = layout.begin;
+    begin.assign(num_groups + 1, 0);
+    for (auto group : row_groups) {
+        if (group != NO_GROUP) {
+            ++begin[group + 1];
+        }
+    }
+    for (size_t group = 0; group < num_groups; ++group) {
+        begin[group + 1] += begin[group];
+    }
+
+    layout.rows.resize(begin[num_groups]);
+    std::vector<size_t> position(begin.begin(), begin.end() - 1);
+    for (int i = 0; i < row_groups.size(); ++i) {
+        if (row_groups[i] != NO_GROUP) {
+            layout.rows[position[row_groups[i]]++] = i;
+        }
+    }
+}
+
+void aggregate_groups(const std::vector<double>& values, const GroupLayout& layout,
+                      std::vector<Aggregate>& aggregates) {
+    auto num_groups = layout.begin.size() - 1;
+    auto num_rows = layout.rows.size();
+    aggregates.assign(num_groups, Aggregate());
+
+    // Each task totals up its share of the rows. Groups that straddle
+    // the shares of several tasks get a partial total from each one,
+    // which are merged after.
+    auto num_tasks = (int)((num_rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK);
+    std::vector<std::vector<std::pair<size_t, Aggregate>>> partials(num_tasks);
+    WorkerPool::shared().parallel_for(num_tasks, [&](int k) {
+        auto task_begin = k * ROWS_PER_TASK;
+        auto task_end = std::min(task_begin + ROWS_PER_TASK, num_rows);
+        auto group = (size_t)(std::upper_bound(layout.begin.begin(), layout.begin.end(), task_begin) - layout.begin.begin()) - 1;
+
+        double gathered[1024];
+        for (; group < num_groups && layout.begin[group] < task_end; ++group) {
+            auto begin = std::max(layout.begin[group], task_begin);
+            auto end = std::min(layout.begin[group + 1], task_end);
+            if (begin == end) {
+                continue;
+            }
+            Aggregate aggregate;
+            for (; begin < end; begin += 1024) {
+                auto size = std::min(end - begin, (size_t)1024);
+                for (size_t r = 0; r < size; ++r) {
+                    gathered[r] = values[layout.rows[begin + r]];
+                }
+                aggregate_values(gathered, size, aggregate);
+            }
+            if (layout.begin[group] < task_begin || layout.begin[group + 1] > task_end) {
+                partials[k].push_back(std::make_pair(group, aggregate));
+            } else {
+                aggregates[group] = aggregate;
+            }
+        }
+    });
+
+    for (auto& task_partials : partials) {
+        for (auto& partial : task_partials) {
+            merge_aggregate(aggregates[partial.first], partial.second);
+        }
+    }
+}
+
+}
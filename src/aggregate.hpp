@@ -0,0 +1,71 @@
+//
+//  aggregate.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_aggregate_hpp
+#define ddui_table_aggregate_hpp
+
+#include "model.hpp"
+#include <math.h>
+
+namespace Table {
+
+// Totals of the numeric values of a column over the rows of a group.
+// Empty cells, and cells that aren't numbers, are left out.
+struct Aggregate {
+    int count = 0;
+    double sum = 0;
+    double min = INFINITY;
+    double max = -INFINITY;
+
+    double mean() const {
+        return count == 0 ? NAN : sum / count;
+    }
+};
+
+void merge_aggregate(Aggregate& aggregate, const Aggregate& other);
+
+// Adds values[0..count) to the aggregate, skipping NaN. Runs on AVX or
+// SSE2 vectors when the build targets them.
+void aggregate_values(const double* values, size_t count, Aggregate& aggregate);
+
+// Numeric values of columns, read once per model ref: typed columns
+// directly, and string columns through parse_double. Cells that are
+// empty or don't parse are NaN.
+struct NumberCache {
+    struct Column {
+        long ref = -1;
+        std::vector<double> values;
+    };
+    std::vector<Column> columns;
+};
+
+const std::vector<double>& column_numbers(Model& model, int j, NumberCache& number_cache);
+
+// Numeric value of a single cell, as column_numbers reads it
+double cell_number(Model& model, int i, int j);
+
+// Rows laid out group after group, in model order within each group:
+// the rows of group g are rows[begin[g], begin[g + 1]).
+struct GroupLayout {
+    std::vector<int> rows;
+    std::vector<size_t> begin;
+};
+
+// Lays out the rows by row_groups[row], which is a group below
+// num_groups or ~0 for rows in no group, with a counting sort
+void layout_groups(const std::vector<uint32_t>& row_groups, size_t num_groups, GroupLayout& layout);
+
+// Totals up the values of the rows of every group of the layout. Each
+// group's values are gathered into a contiguous run and reduced with
+// aggregate_values, with runs spread over the shared WorkerPool.
+void aggregate_groups(const std::vector<double>& values, const GroupLayout& layout,
+                      std::vector<Aggregate>& aggregates);
+
+}
+
+#endif
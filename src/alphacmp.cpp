@@ -7,24 +7,25 @@
 //
 
 #include "alphacmp.hpp"
+#include <string.h>
 
 namespace Table {
 
 // Taken from: http://www.davekoelle.com/alphanum.html
 
-int alphacmp_std_string(const std::string& l, const std::string& r) {
-    return alphacmp(l.c_str(), r.c_str());
+int alphacmp_std_string(std::string_view l, std::string_view r) {
+    return alphacmp(l, r);
 }
 
 static inline bool is_digit(char ch) {
     return ch >= '0' && ch <= '9';
 }
 
-unsigned long read_number(const char** str) {
+unsigned long read_number(const char** str, const char* end) {
     const char* ch = *str;
     unsigned long value = 0;
 
-    while (is_digit(*ch)) {
+    while (ch < end && is_digit(*ch)) {
         value = value * 10 + (unsigned long)(*ch++ - '0');
     }
 
@@ -33,13 +34,24 @@ unsigned long read_number(const char** str) {
 }
 
 int alphacmp(const char *l, const char *r) {
+    return alphacmp(std::string_view(l, strlen(l)), std::string_view(r, strlen(r)));
+}
+
+int alphacmp(std::string_view l_view, std::string_view r_view) {
     enum mode_t { STRING, NUMBER } mode=STRING;
 
-    while (*l && *r) {
+    // Strings are bounded by their length rather than a terminator, so
+    // cells can be compared in place
+    const char* l = l_view.data();
+    const char* r = r_view.data();
+    const char* l_end = l + l_view.size();
+    const char* r_end = r + r_view.size();
+
+    while (l < l_end && r < r_end) {
         if (mode == STRING) {
 
-            char l_char, r_char;
-            while ((l_char=*l) && (r_char=*r)) {
+            while (l < l_end && r < r_end) {
+                char l_char = *l, r_char = *r;
                 // check if this are digit characters
                 const bool l_digit = is_digit(l_char), r_digit=is_digit(r_char);
                 // if both characters are digits, we continue in NUMBER mode
@@ -62,30 +74,70 @@ int alphacmp(const char *l, const char *r) {
 
         } else {
             // get the left number
-            unsigned long l_int = read_number(&l);
+            unsigned long l_int = read_number(&l, l_end);
 
             // get the right number
-            unsigned long r_int = read_number(&r);
+            unsigned long r_int = read_number(&r, r_end);
 
-            // if the difference is not equal to zero, we have a comparison result
-            const long diff=l_int-r_int;
-            if (diff != 0) return diff;
+            // if the numbers differ, we have a comparison result
+            if (l_int != r_int) return l_int < r_int ? -1 : +1;
 
             // otherwise we process the next substring in STRING mode
             mode=STRING;
         }
     }
 
-    if(*r) return -1;
-    if(*l) return +1;
+    if(r < r_end) return -1;
+    if(l < l_end) return +1;
     return 0;
 }
 
-bool alphacmp_ascending(const std::string& l, const std::string& r) {
-    return alphacmp_std_string(l, r) < 0;
+// Keys are a sequence of tokens, one per character outside digit runs
+// and one per digit run, so that two values line up token by token for
+// as long as alphacmp would compare them:
+//
+//   digit run:     0x01, the number of bytes in the value, then the
+//                  value's significant bytes, most significant first
+//   other char:    its position among the non-digit chars, in signed
+//                  char order, plus 2 (so between 0x02 and 0xF7)
+//
+// The end of the value sorts before everything else, as a digit run
+// sorts before any other char.
+void alphacmp_sort_key(std::string_view value, std::string& key) {
+    const char* ch = value.data();
+    const char* end = ch + value.size();
+
+    while (ch < end) {
+        if (is_digit(*ch)) {
+            auto number = read_number(&ch, end);
+            unsigned char bytes[sizeof(number)];
+            int length = 0;
+            for (; number != 0; number >>= 8) {
+                bytes[length++] = (unsigned char)(number & 0xff);
+            }
+            key.push_back(0x01);
+            key.push_back((char)length);
+            while (length > 0) {
+                key.push_back((char)bytes[--length]);
+            }
+            continue;
+        }
+
+        // Flip the sign bit to get signed order, then close the gap
+        // left by the digits
+        auto position = (unsigned char)(*ch++) ^ 0x80;
+        if (position > ('9' ^ 0x80)) {
+            position -= 10;
+        }
+        key.push_back((char)(position + 2));
+    }
+}
+
+bool alphacmp_ascending(std::string_view l, std::string_view r) {
+    return alphacmp(l, r) < 0;
 }
-bool alphacmp_descending(const std::string& l, const std::string& r) {
-    return alphacmp_std_string(l, r) > 0;
+bool alphacmp_descending(std::string_view l, std::string_view r) {
+    return alphacmp(l, r) > 0;
 }
 
 }
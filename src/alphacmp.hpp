@@ -10,17 +10,26 @@
 #define ddui_table_alphacmp_hpp
 
 #include <string>
+#include <string_view>
 
 namespace Table {
 
 int alphacmp(const char *l, const char *r);
-int alphacmp_std_string(const std::string& l, const std::string& r);
-bool alphacmp_ascending(const std::string& l, const std::string& r);
-bool alphacmp_descending(const std::string& l, const std::string& r);
+int alphacmp(std::string_view l, std::string_view r);
+int alphacmp_std_string(std::string_view l, std::string_view r);
+bool alphacmp_ascending(std::string_view l, std::string_view r);
+bool alphacmp_descending(std::string_view l, std::string_view r);
+
+// Appends a binary key for value to `key`, such that comparing two
+// keys with memcmp (a shorter key ordering before any key it is a
+// prefix of) gives the same order as alphacmp, and keys are equal
+// exactly when alphacmp returns 0.
+void alphacmp_sort_key(std::string_view value, std::string& key);
 
 struct alphacmp_operator {
-    bool operator()(const std::string& l, const std::string& r) const {
-        return alphacmp(l.c_str(), r.c_str()) < 0;
+    using is_transparent = void;
+    bool operator()(std::string_view l, std::string_view r) const {
+        return alphacmp(l, r) < 0;
     }
 };
 
@@ -0,0 +1,515 @@
+//
+//  columnar_model.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "columnar_model.hpp"
+#include "typed_value.hpp"
+#include <algorithm>
+#include <string.h>
+
+namespace Table {
+
+ColumnarModel::ColumnarModel(std::vector<std::string> headers,
+                             std::vector<std::string> key) {
+    version_count = 1;
+    change_log.reset(version_count);
+    num_rows = 0;
+    scratch_index = 0;
+    editable = true;
+    this->headers = std::move(headers);
+
+    if (this->headers.empty()) {
+        throw "Headers not set yet";
+    }
+
+    data.resize(this->headers.size());
+    for (auto& column : data) {
+        column.type = COLUMN_STRING;
+        column.dictionary = false;
+        column.garbage_bytes = 0;
+    }
+
+    for (auto& header : key) {
+        auto index = get_header_index(this, header);
+        if (index == -1) {
+            throw "Header used as key is not present in table";
+        }
+        this->key_.push_back(index);
+    }
+}
+
+void ColumnarModel::insert_row(std::vector<std::string> row) {
+    check_row(row);
+    version_count++;
+
+    ModelDelta delta;
+    auto replaced = upsert_row(std::move(row));
+    if (replaced == -1) {
+        delta.appended_rows = 1;
+    } else {
+        delta.updated_rows.push_back(replaced);
+    }
+    change_log.record(version_count, num_rows, std::move(delta));
+}
+
+void ColumnarModel::insert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row(row);
+    }
+
+    // Resolve all keys up front, so a conflict leaves the table untouched
+    std::vector<std::string> encoded_keys;
+    if (!key_.empty()) {
+        encoded_keys.reserve(rows.size());
+        std::unordered_map<std::string, int> batch_keys;
+        batch_keys.reserve(rows.size());
+        for (auto& row : rows) {
+            auto encoded = encode_row_key(row);
+            if (key_index.find(encoded) != key_index.end() ||
+                !batch_keys.insert(std::make_pair(encoded, 0)).second) {
+                throw "Row with this key is already present in table";
+            }
+            encoded_keys.push_back(std::move(encoded));
+        }
+        key_index.reserve(key_index.size() + rows.size());
+    }
+
+    reserve(num_rows + rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        if (!key_.empty()) {
+            key_index.insert(std::make_pair(std::move(encoded_keys[i]), num_rows));
+        }
+        for (int j = 0; j < data.size(); ++j) {
+            append_cell(data[j], rows[i][j]);
+        }
+        ++num_rows;
+    }
+
+    version_count++;
+
+    ModelDelta delta;
+    delta.appended_rows = rows.size();
+    change_log.record(version_count, num_rows, std::move(delta));
+}
+
+void ColumnarModel::upsert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row(row);
+    }
+
+    reserve(num_rows + rows.size());
+    if (!key_.empty()) {
+        key_index.reserve(key_index.size() + rows.size());
+    }
+
+    ModelDelta delta;
+    int rows_before = num_rows;
+    for (auto& row : rows) {
+        auto replaced = upsert_row(std::move(row));
+        if (replaced != -1 && replaced < rows_before) {
+            delta.updated_rows.push_back(replaced);
+        }
+    }
+    std::sort(delta.updated_rows.begin(), delta.updated_rows.end());
+    delta.updated_rows.erase(std::unique(delta.updated_rows.begin(), delta.updated_rows.end()),
+                             delta.updated_rows.end());
+    delta.appended_rows = num_rows - rows_before;
+
+    version_count++;
+    change_log.record(version_count, num_rows, std::move(delta));
+}
+
+void ColumnarModel::reserve(int rows) {
+    for (auto& column : data) {
+        if (column.type == COLUMN_DOUBLE) {
+            column.doubles.reserve(rows);
+        } else if (column.type != COLUMN_STRING) {
+            column.ints.reserve(rows);
+        } else if (column.dictionary) {
+            column.ids.reserve(rows);
+        } else {
+            column.offsets.reserve(rows);
+            column.lengths.reserve(rows);
+        }
+    }
+}
+
+void ColumnarModel::set_column_dictionary(int col, bool enabled) {
+    auto& column = data[col];
+    if (column.dictionary == enabled) {
+        return;
+    }
+    if (column.type != COLUMN_STRING) {
+        throw "Typed columns cannot be dictionary encoded";
+    }
+
+    Column converted;
+    converted.type = COLUMN_STRING;
+    converted.dictionary = enabled;
+    converted.garbage_bytes = 0;
+
+    if (enabled) {
+        converted.ids.reserve(num_rows);
+        for (int i = 0; i < num_rows; ++i) {
+            converted.ids.push_back(intern(converted, cell_text(i, col)));
+        }
+    } else {
+        converted.offsets.reserve(num_rows);
+        converted.lengths.reserve(num_rows);
+        for (int i = 0; i < num_rows; ++i) {
+            append_cell(converted, column.values[column.ids[i]]);
+        }
+    }
+
+    column = std::move(converted);
+
+    // The text of the cells is unchanged
+    ++version_count;
+    change_log.record(version_count, num_rows, ModelDelta());
+}
+
+void ColumnarModel::set_column_type(int col, ColumnType type) {
+    auto& column = data[col];
+    if (column.type == type) {
+        return;
+    }
+    if (column.dictionary) {
+        throw "Dictionary encoded columns cannot be typed";
+    }
+
+    // Convert into a separate column first, so that a cell that fails
+    // to parse leaves the table untouched
+    Column converted;
+    converted.type = type;
+    converted.dictionary = false;
+    converted.garbage_bytes = 0;
+    for (int i = 0; i < num_rows; ++i) {
+        append_cell(converted, cell_text(i, col));
+    }
+
+    std::swap(column, converted);
+
+    // Keys are encoded from the formatted text, which may have changed.
+    // Keys that become equal once formatted leave the table untouched.
+    if (std::find(key_.begin(), key_.end(), col) != key_.end()) {
+        try {
+            rebuild_key_index();
+        } catch (...) {
+            std::swap(column, converted);
+            rebuild_key_index();
+            throw;
+        }
+    }
+
+    // Formatting may have changed the text of any cell
+    ++version_count;
+    change_log.reset(version_count);
+}
+
+const std::string& ColumnarModel::cell_text(int row, int col) {
+    auto& column = data[col];
+    switch (column.type) {
+        case COLUMN_INT64: {
+            auto& text = next_scratch();
+            format_int64(column.ints[row], text);
+            return text;
+        }
+        case COLUMN_DOUBLE: {
+            auto& text = next_scratch();
+            format_double(column.doubles[row], text);
+            return text;
+        }
+        case COLUMN_TIMESTAMP: {
+            auto& text = next_scratch();
+            format_timestamp(column.ints[row], text);
+            return text;
+        }
+        case COLUMN_STRING:
+            break;
+    }
+
+    if (column.dictionary) {
+        return column.values[column.ids[row]];
+    }
+
+    auto& text = next_scratch();
+    text.assign(column.arena.data() + column.offsets[row], column.lengths[row]);
+    return text;
+}
+
+std::string_view ColumnarModel::cell_view(int row, int col) {
+    auto& column = data[col];
+    if (column.type != COLUMN_STRING) {
+        return cell_text(row, col);
+    }
+    if (column.dictionary) {
+        return column.values[column.ids[row]];
+    }
+    return std::string_view(column.arena.data() + column.offsets[row], column.lengths[row]);
+}
+
+void ColumnarModel::cells(int col, int row_begin, int row_end, std::string_view* out) {
+    auto& column = data[col];
+
+    if (column.type != COLUMN_STRING) {
+        auto& scratch = column.bulk_scratch;
+        if (scratch.size() < row_end - row_begin) {
+            scratch.resize(row_end - row_begin);
+        }
+        for (int i = row_begin; i < row_end; ++i) {
+            auto& text = scratch[i - row_begin];
+            switch (column.type) {
+                case COLUMN_INT64:     format_int64(column.ints[i], text); break;
+                case COLUMN_DOUBLE:    format_double(column.doubles[i], text); break;
+                case COLUMN_TIMESTAMP: format_timestamp(column.ints[i], text); break;
+                case COLUMN_STRING:    break;
+            }
+            *out++ = text;
+        }
+        return;
+    }
+
+    if (column.dictionary) {
+        for (int i = row_begin; i < row_end; ++i) {
+            *out++ = column.values[column.ids[i]];
+        }
+        return;
+    }
+
+    auto arena = column.arena.data();
+    for (int i = row_begin; i < row_end; ++i) {
+        *out++ = std::string_view(arena + column.offsets[i], column.lengths[i]);
+    }
+}
+
+void ColumnarModel::set_cell_text(int row, int col, const std::string& text) {
+    check_cell(col, text);
+
+    bool is_key_column = false;
+    for (auto j : key_) {
+        if (j == col) {
+            is_key_column = true;
+            break;
+        }
+    }
+
+    if (!is_key_column) {
+        assign_cell(data[col], row, text);
+        record_cell_update(row, col);
+        return;
+    }
+
+    // The row moves to a different key, so re-index it. Check that no
+    // other row has the new key first, so a conflict leaves the table
+    // untouched.
+    std::string new_encoded;
+    for (auto j : key_) {
+        append_key_text(new_encoded, j, j == col ? text : cell_text(row, j));
+    }
+    auto conflict = key_index.find(new_encoded);
+    if (conflict != key_index.end() && conflict->second != row) {
+        throw "Row with this key is already present in table";
+    }
+
+    auto lookup = key_index.find(encode_key(this, row, key_));
+    if (lookup != key_index.end() && lookup->second == row) {
+        key_index.erase(lookup);
+    }
+    assign_cell(data[col], row, text);
+    key_index.insert(std::make_pair(std::move(new_encoded), row));
+    record_cell_update(row, col);
+}
+
+void ColumnarModel::record_cell_update(int row, int col) {
+    ++version_count;
+    ModelDelta delta;
+    delta.updated_cells.push_back(std::make_pair(row, col));
+    change_log.record(version_count, num_rows, std::move(delta));
+}
+
+void ColumnarModel::check_row(const std::vector<std::string>& row) {
+    if (row.size() != headers.size()) {
+        throw "Row and header has different number of columns";
+    }
+
+    for (int j = 0; j < data.size(); ++j) {
+        check_cell(j, row[j]);
+    }
+}
+
+void ColumnarModel::check_cell(int col, const std::string& text) {
+    int64_t int_value;
+    double double_value;
+    bool parsed = true;
+    switch (data[col].type) {
+        case COLUMN_INT64:     parsed = parse_int64(text, &int_value); break;
+        case COLUMN_DOUBLE:    parsed = parse_double(text, &double_value); break;
+        case COLUMN_TIMESTAMP: parsed = parse_timestamp(text, &int_value); break;
+        case COLUMN_STRING:    break;
+    }
+    if (!parsed) {
+        throw "Cell text does not parse as the column type";
+    }
+}
+
+// Keys are encoded from the text that cells read back as, so that for
+// example "1.0" and "1" are the same key in a DOUBLE column
+std::string ColumnarModel::encode_row_key(const std::vector<std::string>& row) {
+    std::string encoded;
+    for (auto j : key_) {
+        append_key_text(encoded, j, row[j]);
+    }
+    return encoded;
+}
+
+void ColumnarModel::append_key_text(std::string& encoded, int col, const std::string& text) {
+    int64_t int_value;
+    double double_value;
+    std::string formatted;
+    switch (data[col].type) {
+        case COLUMN_INT64:
+            parse_int64(text, &int_value);
+            format_int64(int_value, formatted);
+            break;
+        case COLUMN_DOUBLE:
+            parse_double(text, &double_value);
+            format_double(double_value, formatted);
+            break;
+        case COLUMN_TIMESTAMP:
+            parse_timestamp(text, &int_value);
+            format_timestamp(int_value, formatted);
+            break;
+        case COLUMN_STRING:
+            append_key_cell(encoded, text);
+            return;
+    }
+    append_key_cell(encoded, formatted);
+}
+
+void ColumnarModel::rebuild_key_index() {
+    key_index.clear();
+    key_index.reserve(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        if (!key_index.insert(std::make_pair(encode_key(this, i, key_), i)).second) {
+            throw "Row with this key is already present in table";
+        }
+    }
+}
+
+int ColumnarModel::upsert_row(std::vector<std::string>&& row) {
+    if (!key_.empty()) {
+        auto encoded = encode_row_key(row);
+        auto lookup = key_index.find(encoded);
+        if (lookup != key_index.end()) {
+            for (int j = 0; j < data.size(); ++j) {
+                assign_cell(data[j], lookup->second, row[j]);
+            }
+            return lookup->second;
+        }
+        key_index.insert(std::make_pair(std::move(encoded), num_rows));
+    }
+
+    for (int j = 0; j < data.size(); ++j) {
+        append_cell(data[j], row[j]);
+    }
+    ++num_rows;
+    return -1;
+}
+
+void ColumnarModel::append_cell(Column& column, const std::string& text) {
+    if (column.type == COLUMN_DOUBLE) {
+        column.doubles.push_back(0);
+        assign_cell(column, column.doubles.size() - 1, text);
+        return;
+    }
+    if (column.type != COLUMN_STRING) {
+        column.ints.push_back(0);
+        assign_cell(column, column.ints.size() - 1, text);
+        return;
+    }
+
+    if (column.dictionary) {
+        column.ids.push_back(intern(column, text));
+        return;
+    }
+
+    column.offsets.push_back(column.arena.size());
+    column.lengths.push_back(text.size());
+    column.arena.insert(column.arena.end(), text.begin(), text.end());
+}
+
+void ColumnarModel::assign_cell(Column& column, int row, const std::string& text) {
+    bool parsed = true;
+    switch (column.type) {
+        case COLUMN_INT64:     parsed = parse_int64(text, &column.ints[row]); break;
+        case COLUMN_DOUBLE:    parsed = parse_double(text, &column.doubles[row]); break;
+        case COLUMN_TIMESTAMP: parsed = parse_timestamp(text, &column.ints[row]); break;
+        case COLUMN_STRING:    break;
+    }
+    if (!parsed) {
+        throw "Cell text does not parse as the column type";
+    }
+    if (column.type != COLUMN_STRING) {
+        return;
+    }
+
+    if (column.dictionary) {
+        column.ids[row] = intern(column, text);
+        return;
+    }
+
+    // Overwrite in place when the new text fits, otherwise append it to
+    // the end of the arena and leave the old bytes as garbage
+    if (text.size() <= column.lengths[row]) {
+        if (!text.empty()) {
+            memcpy(&column.arena[column.offsets[row]], text.data(), text.size());
+        }
+        column.garbage_bytes += column.lengths[row] - text.size();
+        column.lengths[row] = text.size();
+    } else {
+        column.garbage_bytes += column.lengths[row];
+        column.offsets[row] = column.arena.size();
+        column.lengths[row] = text.size();
+        column.arena.insert(column.arena.end(), text.begin(), text.end());
+    }
+
+    if (column.garbage_bytes > column.arena.size() / 2) {
+        compact(column);
+    }
+}
+
+void ColumnarModel::compact(Column& column) {
+    std::vector<char> arena;
+    arena.reserve(column.arena.size() - column.garbage_bytes);
+    for (int i = 0; i < column.offsets.size(); ++i) {
+        auto begin = column.arena.begin() + column.offsets[i];
+        column.offsets[i] = arena.size();
+        arena.insert(arena.end(), begin, begin + column.lengths[i]);
+    }
+    column.arena = std::move(arena);
+    column.garbage_bytes = 0;
+}
+
+std::string& ColumnarModel::next_scratch() {
+    auto& text = scratch[scratch_index];
+    scratch_index = (scratch_index + 1) % SCRATCH_SLOTS;
+    return text;
+}
+
+uint32_t ColumnarModel::intern(Column& column, const std::string& text) {
+    auto lookup = column.value_ids.find(text);
+    if (lookup != column.value_ids.end()) {
+        return lookup->second;
+    }
+
+    uint32_t id = column.values.size();
+    column.values.push_back(text);
+    column.value_ids.insert(std::make_pair(text, id));
+    return id;
+}
+
+}
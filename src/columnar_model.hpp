@@ -0,0 +1,155 @@
+//
+//  columnar_model.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_columnar_model_hpp
+#define ddui_table_columnar_model_hpp
+
+#include "model.hpp"
+#include <algorithm>
+
+namespace Table {
+
+// A model that stores each column as one contiguous byte arena with
+// an offset and length per cell, rather than a std::string per cell.
+// Scanning a single column (filtering, sorting) walks through memory
+// linearly and there is no per-cell allocation.
+//
+// cell_text() materialises the cell into one of a small ring of
+// scratch strings. The reference stays valid until SCRATCH_SLOTS
+// further calls to cell_text() have been made, which is enough for
+// comparing cells pairwise. cell_view() returns string and dictionary
+// cells in place, valid until the model is next modified.
+//
+// Low-cardinality columns can be switched to dictionary encoding with
+// set_column_dictionary(), after which a cell is a 4-byte id into a
+// table of distinct values. Numeric and timestamp columns can be
+// switched to a typed representation with set_column_type(), after
+// which cells are kept parsed and only formatted when their text is
+// asked for. Text that does not parse as the column type is rejected.
+// Keys are matched by the formatted text of typed cells, so "1.0" and
+// "1" are the same key in a DOUBLE column.
+class ColumnarModel : public Model {
+    public:
+        ColumnarModel(std::vector<std::string> headers,
+                      std::vector<std::string> key);
+        void insert_row(std::vector<std::string> row);
+        void insert_rows(std::vector<std::vector<std::string>> rows);
+        void upsert_rows(std::vector<std::vector<std::string>> rows);
+        void reserve(int rows);
+        void set_column_dictionary(int col, bool enabled);
+        void set_column_type(int col, ColumnType type);
+        bool editable;
+
+        // Implement Model methods
+        long ref() {
+            return version_count;
+        }
+        int columns() {
+            return headers.size();
+        }
+        int rows() {
+            return num_rows;
+        }
+        const std::string& header_text(int col) {
+            return headers[col];
+        }
+        const std::string& cell_text(int row, int col);
+        std::string_view cell_view(int row, int col);
+        void cells(int col, int row_begin, int row_end, std::string_view* out);
+        std::vector<int> key() {
+            return key_;
+        }
+        bool cell_editable(int row, int col) {
+            return editable;
+        }
+        void set_cell_text(int row, int col, const std::string& text);
+        bool column_has_dictionary(int col) {
+            return data[col].dictionary;
+        }
+        int dictionary_size(int col) {
+            return data[col].values.size();
+        }
+        const std::string& dictionary_text(int col, uint32_t id) {
+            return data[col].values[id];
+        }
+        uint32_t cell_id(int row, int col) {
+            return data[col].ids[row];
+        }
+        void cell_ids(int col, int row_begin, int row_end, uint32_t* out) {
+            auto& ids = data[col].ids;
+            std::copy(ids.begin() + row_begin, ids.begin() + row_end, out);
+        }
+        ColumnType column_type(int col) {
+            return data[col].type;
+        }
+        int64_t cell_int64(int row, int col) {
+            return data[col].ints[row];
+        }
+        double cell_double(int row, int col) {
+            return data[col].doubles[row];
+        }
+        bool delta(long since_ref, ModelDelta* delta) {
+            return change_log.collect(since_ref, delta);
+        }
+        bool concurrent_cells(int col) {
+            return data[col].type == COLUMN_STRING; // typed cells are formatted into scratch strings
+        }
+
+    private:
+        struct Column {
+            ColumnType type;
+            bool dictionary;
+
+            // String storage
+            std::vector<char> arena;
+            std::vector<size_t> offsets;
+            std::vector<unsigned> lengths;
+            size_t garbage_bytes; // bytes no longer referenced by a cell
+
+            // Dictionary storage
+            std::vector<uint32_t> ids;
+            std::vector<std::string> values;
+            std::unordered_map<std::string, uint32_t> value_ids;
+
+            // Typed storage
+            std::vector<int64_t> ints; // INT64 and TIMESTAMP
+            std::vector<double> doubles;
+
+            // Formatted text of typed cells handed out by cells()
+            std::vector<std::string> bulk_scratch;
+        };
+
+        static constexpr int SCRATCH_SLOTS = 16;
+
+        void check_row(const std::vector<std::string>& row);
+        void check_cell(int col, const std::string& text);
+        std::string encode_row_key(const std::vector<std::string>& row);
+        void append_key_text(std::string& encoded, int col, const std::string& text);
+        void rebuild_key_index();
+        int upsert_row(std::vector<std::string>&& row);
+        void record_cell_update(int row, int col);
+        void append_cell(Column& column, const std::string& text);
+        void assign_cell(Column& column, int row, const std::string& text);
+        void compact(Column& column);
+        uint32_t intern(Column& column, const std::string& text);
+        std::string& next_scratch();
+
+        int version_count; // increments when state is changed
+        int num_rows;
+        std::vector<std::string> headers;
+        std::vector<Column> data;
+        std::vector<int> key_;
+        std::unordered_map<std::string, int> key_index; // encoded key -> row
+        ChangeLog change_log;
+        std::string scratch[SCRATCH_SLOTS];
+        int scratch_index;
+};
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+//
+//  concurrent_model.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "concurrent_model.hpp"
+#include <algorithm>
+
+namespace Table {
+
+ConcurrentModel::ConcurrentModel(std::vector<std::string> headers,
+                                 std::vector<std::string> key) {
+    this->headers = std::move(headers);
+
+    if (this->headers.empty()) {
+        throw "Headers not set yet";
+    }
+
+    for (auto& header : key) {
+        auto index = get_header_index(this, header);
+        if (index == -1) {
+            throw "Header used as key is not present in table";
+        }
+        this->key_.push_back(index);
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->generation = 1;
+    snapshot->rows = 0;
+    snapshot->delta_base = -1;
+
+    latest = snapshot;
+    published = snapshot;
+    current = snapshot;
+    acknowledged_generation = snapshot->generation;
+    change_log.reset(snapshot->generation);
+}
+
+void ConcurrentModel::insert_row(std::vector<std::string> row) {
+    check_row_size(row);
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    if (!key_.empty()) {
+        staged_keys.insert(encode_key(row, key_));
+    }
+    staging.push_back(std::move(row));
+}
+
+void ConcurrentModel::insert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row_size(row);
+    }
+    std::lock_guard<std::mutex> lock(writer_mutex);
+
+    // Resolve all keys up front, so a conflict leaves the staged rows
+    // untouched
+    std::vector<std::string> encoded_keys;
+    if (!key_.empty()) {
+        encoded_keys.reserve(rows.size());
+        std::unordered_set<std::string> batch_keys;
+        for (auto& row : rows) {
+            auto encoded = encode_key(row, key_);
+            if (key_index.find(encoded) != key_index.end() ||
+                staged_keys.find(encoded) != staged_keys.end() ||
+                !batch_keys.insert(encoded).second) {
+                throw "Row with this key is already present in table";
+            }
+            encoded_keys.push_back(std::move(encoded));
+        }
+    }
+
+    staging.reserve(staging.size() + rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        if (!key_.empty()) {
+            staged_keys.insert(std::move(encoded_keys[i]));
+        }
+        staging.push_back(std::move(rows[i]));
+    }
+}
+
+void ConcurrentModel::upsert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row_size(row);
+    }
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    staging.reserve(staging.size() + rows.size());
+    for (auto& row : rows) {
+        if (!key_.empty()) {
+            staged_keys.insert(encode_key(row, key_));
+        }
+        staging.push_back(std::move(row));
+    }
+}
+
+void ConcurrentModel::publish() {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    if (staging.empty()) {
+        return;
+    }
+
+    auto next = std::make_shared<Snapshot>();
+    next->generation = latest->generation + 1;
+    next->rows = latest->rows;
+    next->chunks = latest->chunks;
+
+    // Chunks copied for this snapshot, which no reader can see yet
+    std::vector<bool> owned(next->chunks.size(), false);
+
+    ModelDelta delta;
+    auto rows_before = latest->rows;
+
+    for (auto& row : staging) {
+
+        // Upsert: copy the chunk holding the row on first write
+        if (!key_.empty()) {
+            auto encoded = encode_key(row, key_);
+            auto lookup = key_index.find(encoded);
+            if (lookup != key_index.end()) {
+                auto i = lookup->second;
+                auto c = i / CHUNK_ROWS;
+                if (!owned[c]) {
+                    next->chunks[c] = new_chunk(next->chunks[c].get());
+                    owned[c] = true;
+                }
+                next->chunks[c]->rows[i % CHUNK_ROWS] = std::move(row);
+                if (i < rows_before) {
+                    delta.updated_rows.push_back(i);
+                }
+                continue;
+            }
+            key_index.insert(std::make_pair(std::move(encoded), next->rows));
+        }
+
+        // Append: older snapshots only see the rows before their count
+        if (next->rows % CHUNK_ROWS == 0) {
+            next->chunks.push_back(new_chunk(NULL));
+            owned.push_back(true);
+        }
+        next->chunks.back()->rows[next->rows % CHUNK_ROWS] = std::move(row);
+        ++next->rows;
+    }
+    staging.clear();
+    staged_keys.clear();
+
+    std::sort(delta.updated_rows.begin(), delta.updated_rows.end());
+    delta.updated_rows.erase(std::unique(delta.updated_rows.begin(), delta.updated_rows.end()),
+                             delta.updated_rows.end());
+    delta.appended_rows = next->rows - rows_before;
+    change_log.record(next->generation, next->rows, std::move(delta));
+
+    // Describe the change relative to the generation the UI last took
+    next->delta_base = acknowledged_generation.load();
+    if (!change_log.collect(next->delta_base, &next->delta)) {
+        next->delta_base = -1;
+    }
+
+    latest = next;
+    std::atomic_store(&published, latest);
+}
+
+void ConcurrentModel::begin_update() {
+    current = std::atomic_load(&published);
+    acknowledged_generation.store(current->generation);
+}
+
+void ConcurrentModel::cells(int col, int row_begin, int row_end, std::string_view* out) {
+    for (int i = row_begin; i < row_end; ++i) {
+        *out++ = current->row(i)[col];
+    }
+}
+
+bool ConcurrentModel::delta(long since_ref, ModelDelta* delta) {
+    if (since_ref == current->generation) {
+        *delta = ModelDelta();
+        return true;
+    }
+    if (current->delta_base == -1 || current->delta_base != since_ref) {
+        return false;
+    }
+    *delta = current->delta;
+    return true;
+}
+
+void ConcurrentModel::check_row_size(const std::vector<std::string>& row) {
+    if (row.size() != headers.size()) {
+        throw "Row and header has different number of columns";
+    }
+}
+
+std::shared_ptr<ConcurrentModel::Chunk> ConcurrentModel::new_chunk(const Chunk* copy_from) {
+    auto chunk = std::make_shared<Chunk>();
+    if (copy_from != NULL) {
+        chunk->rows = copy_from->rows;
+    }
+    return chunk;
+}
+
+}
@@ -0,0 +1,129 @@
+//
+//  concurrent_model.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_concurrent_model_hpp
+#define ddui_table_concurrent_model_hpp
+
+#include "model.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace Table {
+
+// A model that background threads can write into while the UI thread
+// reads from it.
+//
+// Writers call insert_row()/insert_rows()/upsert_rows() from any
+// thread, which stage the rows, and then publish() to make them visible.
+// As with BasicModel, insert_row() and upsert_rows() replace rows with
+// a matching key, whereas insert_rows() requires that none of the keys
+// are present or staged yet. Publishing builds
+// a new immutable snapshot (sharing all untouched chunks of rows with
+// the previous one) and swaps it in atomically.
+//
+// The UI thread picks up the latest snapshot in begin_update(), which
+// the view calls once per frame, and reads only from that snapshot
+// until the next frame. Readers never take a lock, and writers never
+// wait on rendering. ref() returns the generation of the snapshot.
+class ConcurrentModel : public Model {
+    public:
+        ConcurrentModel(std::vector<std::string> headers,
+                        std::vector<std::string> key);
+
+        // Writer side, safe to call from any thread
+        void insert_row(std::vector<std::string> row);
+        void insert_rows(std::vector<std::vector<std::string>> rows);
+        void upsert_rows(std::vector<std::vector<std::string>> rows);
+        void publish();
+
+        // Implement Model methods, for the UI thread only
+        void begin_update();
+        long ref() {
+            return current->generation;
+        }
+        int columns() {
+            return headers.size();
+        }
+        int rows() {
+            return current->rows;
+        }
+        const std::string& header_text(int col) {
+            return headers[col];
+        }
+        const std::string& cell_text(int row, int col) {
+            return current->row(row)[col];
+        }
+        std::string_view cell_view(int row, int col) {
+            return current->row(row)[col];
+        }
+        void cells(int col, int row_begin, int row_end, std::string_view* out);
+        std::vector<int> key() {
+            return key_;
+        }
+        void set_cell_text(int row, int col, const std::string& text) {
+            throw "ConcurrentModel can only be written with insert_row()";
+        }
+        bool delta(long since_ref, ModelDelta* delta);
+        bool concurrent_cells(int col) {
+            return true;
+        }
+
+    private:
+        static constexpr int CHUNK_ROWS = 1024;
+
+        // Chunks have a fixed slot for each of their CHUNK_ROWS rows.
+        // Writers append to a chunk that a published snapshot shares by
+        // filling slots past that snapshot's row count, which it never
+        // reads. Rows a snapshot can see are only replaced in a copy.
+        struct Chunk {
+            std::array<std::vector<std::string>, CHUNK_ROWS> rows;
+        };
+
+        struct Snapshot {
+            long generation;
+            int rows;
+            std::vector<std::shared_ptr<Chunk>> chunks;
+
+            // How this snapshot differs from generation delta_base, or
+            // delta_base = -1 when the writer couldn't tell
+            long delta_base;
+            ModelDelta delta;
+
+            const std::vector<std::string>& row(int i) const {
+                return chunks[i / CHUNK_ROWS]->rows[i % CHUNK_ROWS];
+            }
+        };
+
+        void check_row_size(const std::vector<std::string>& row);
+        static std::shared_ptr<Chunk> new_chunk(const Chunk* copy_from);
+
+        std::vector<std::string> headers;
+        std::vector<int> key_;
+
+        // Writer state, guarded by writer_mutex
+        std::mutex writer_mutex;
+        std::vector<std::vector<std::string>> staging;
+        std::unordered_set<std::string> staged_keys; // encoded keys in staging
+        std::unordered_map<std::string, int> key_index; // encoded key -> row
+        ChangeLog change_log;
+        std::shared_ptr<const Snapshot> latest;
+
+        // Shared between writers and the UI thread
+        std::shared_ptr<const Snapshot> published; // std::atomic_load/store only
+        std::atomic<long> acknowledged_generation; // last taken by the UI
+
+        // Reader state
+        std::shared_ptr<const Snapshot> current;
+};
+
+}
+
+#endif
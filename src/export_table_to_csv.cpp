@@ -12,7 +12,7 @@
 
 namespace Table {
 
-static void print_value_safe(std::stringstream& out, std::string value);
+static void print_value_safe(std::stringstream& out, std::string_view value);
 
 std::string export_table_to_csv(State* table) {
 
@@ -33,30 +33,48 @@ std::string export_table_to_csv(State* table) {
     }
     ss << '\n';
 
-    // Step 2. Print all the rows
-    for (auto i : results.row_indices) {
+    // Step 2. Print all the rows. Consecutive model rows are fetched a
+    // run at a time per column, then printed row by row
+    auto& rows = results.row_indices;
+    auto& columns = results.column_indices;
+    std::vector<std::string_view> cells(columns.size() * CELL_CHUNK_SIZE);
+
+    for (int k = 0; k < rows.size(); ) {
 
         // Skip group headings
-        if (i == -1) {
+        if (rows[k] == -1) {
+            ++k;
             continue;
         }
 
-        auto it = results.column_indices.begin();
-        if (it < results.column_indices.end()) {
-            print_value_safe(ss, model.cell_text(i, *it));
-            ++it;
+        auto run_begin = rows[k];
+        auto run_length = 1;
+        while (k + run_length < rows.size() && run_length < CELL_CHUNK_SIZE &&
+               rows[k + run_length] == run_begin + run_length) {
+            ++run_length;
         }
-        for (; it < results.column_indices.end(); ++it) {
-            ss << ',';
-            print_value_safe(ss, model.cell_text(i, *it));
+
+        for (int c = 0; c < columns.size(); ++c) {
+            model.cells(columns[c], run_begin, run_begin + run_length, &cells[c * CELL_CHUNK_SIZE]);
         }
-        ss << '\n';
+
+        for (int r = 0; r < run_length; ++r) {
+            for (int c = 0; c < columns.size(); ++c) {
+                if (c > 0) {
+                    ss << ',';
+                }
+                print_value_safe(ss, cells[c * CELL_CHUNK_SIZE + r]);
+            }
+            ss << '\n';
+        }
+
+        k += run_length;
     }
 
     return ss.str();
 }
 
-static bool value_is_safe(std::string value) {
+static bool value_is_safe(std::string_view value) {
     for (auto i = 0; i < value.size(); ++i) {
         auto ch = value[i];
         if ((ch >= 'a' && ch <= 'z') ||
@@ -74,7 +92,7 @@ static bool value_is_safe(std::string value) {
     return true;
 }
 
-void print_value_safe(std::stringstream& out, std::string value) {
+void print_value_safe(std::stringstream& out, std::string_view value) {
     if (value_is_safe(value)) {
         out << value;
         return;
@@ -10,12 +10,14 @@
 #include "style.hpp"
 #include <ddui/util/draw_text_in_box>
 #include <ddui/views/Overlay>
+#include <algorithm>
 
 namespace Table {
 
 using namespace ddui;
 
 void refresh_results(State* state);
+void refresh_column_values(State* state, int j);
 static void update_filter_buttons(State* state);
 static void update_filter_values(State* state);
 static void draw_filter_overlay_path(float x, float y);
@@ -64,6 +66,7 @@ void update_filter_overlay(State* state) {
 }
 
 std::vector<std::string> prepare_filter_value_list(State* state, int column) {
+    refresh_column_values(state, column);
     auto& values_existing = state->column_values[column];
 
     // For a disabled filter just show all existing values
@@ -157,26 +160,43 @@ void update_filter_buttons(State* state) {
     auto j = state->filter_overlay.active_column;
     
     auto button_height = view.height - 2 * BUTTONS_AREA_MARGIN;
-    auto button_width_1 = (view.width - 2 * BUTTONS_AREA_MARGIN) / 3;
+    auto button_width_1 = (view.width - 2 * BUTTONS_AREA_MARGIN) / 4;
     auto button_width_3 = button_width_1;
-    auto button_width_2 = view.width - 2 * BUTTONS_AREA_MARGIN - button_width_1 - button_width_3 - 2 * BUTTON_SPACING;
+    auto button_width_4 = button_width_1;
+    auto button_width_2 = view.width - 2 * BUTTONS_AREA_MARGIN - button_width_1 - button_width_3 - button_width_4 - 3 * BUTTON_SPACING;
     
     auto y = BUTTONS_AREA_MARGIN;
     auto x1 = BUTTONS_AREA_MARGIN;
     auto x2 = x1 + button_width_1 + BUTTON_SPACING;
     auto x3 = x2 + button_width_2 + BUTTON_SPACING;
+    auto x4 = x3 + button_width_3 + BUTTON_SPACING;
     
-    auto ascending  = (settings.sort_column == j && settings.sort_ascending);
-    auto descending = (settings.sort_column == j && !settings.sort_ascending);
-    auto grouped = (settings.grouped_column == j);
+    auto sort_key = sort_key_index(settings, j);
+    auto ascending  = (sort_key != -1 && settings.sort_keys[sort_key].ascending);
+    auto descending = (sort_key != -1 && !settings.sort_keys[sort_key].ascending);
+    auto group = group_level(settings, j);
+    auto grouped = (group != -1);
+    auto aggregate = std::find(settings.aggregated_columns.begin(), settings.aggregated_columns.end(), j);
+    auto aggregated = (aggregate != settings.aggregated_columns.end());
+
+    // When sorting by several columns, show where this one comes in
+    std::string level;
+    if (sort_key != -1 && settings.sort_keys.size() > 1) {
+        level = " " + std::to_string(sort_key + 1);
+    }
+    auto asc_label = (ascending ? "ASC" + level : std::string("ASC"));
+    auto desc_label = (descending ? "DESC" + level : std::string("DESC"));
+    auto group_label = std::string("GROUP");
+    if (grouped && settings.grouped_columns.size() > 1) {
+        group_label += " " + std::to_string(group + 1);
+    }
     
     if (draw_filter_button(x1, y, button_width_1, button_height,
-                           FORM_LEFT_MOST, ascending, "ASC")) {
+                           FORM_LEFT_MOST, ascending, asc_label.c_str())) {
         state->settings_changed = true;
-        settings.sort_column = ascending ? -1 : j;
-        settings.sort_ascending = true;
+        toggle_sort_key(settings, j, true);
         if (grouped) {
-            settings.grouped_column = -1;
+            settings.grouped_columns.erase(settings.grouped_columns.begin() + group);
             settings.group_collapsed.clear();
             Overlay::close(state);
         }
@@ -184,12 +204,11 @@ void update_filter_buttons(State* state) {
     }
 
     if (draw_filter_button(x2, y, button_width_2, button_height,
-                           FORM_MIDDLE, descending, "DESC")) {
+                           FORM_MIDDLE, descending, desc_label.c_str())) {
         state->settings_changed = true;
-        settings.sort_column = descending ? -1 : j;
-        settings.sort_ascending = false;
+        toggle_sort_key(settings, j, false);
         if (grouped) {
-            settings.grouped_column = -1;
+            settings.grouped_columns.erase(settings.grouped_columns.begin() + group);
             settings.group_collapsed.clear();
             Overlay::close(state);
         }
@@ -197,16 +216,32 @@ void update_filter_buttons(State* state) {
     }
 
     if (draw_filter_button(x3, y, button_width_3, button_height,
-                           FORM_RIGHT_MOST, grouped, "GROUP")) {
+                           FORM_MIDDLE, grouped, group_label.c_str())) {
         state->settings_changed = true;
-        settings.grouped_column = grouped ? -1 : j;
+        if (grouped) {
+            settings.grouped_columns.erase(settings.grouped_columns.begin() + group);
+        } else {
+            settings.grouped_columns.push_back(j);
+        }
         settings.group_collapsed.clear();
-        if (ascending || descending) {
-            settings.sort_column = -1;
+        if (sort_key != -1) {
+            settings.sort_keys.erase(settings.sort_keys.begin() + sort_key);
         }
         refresh_results(state);
         Overlay::close(state);
     }
+
+    // Totals of the column are shown in the group headings
+    if (draw_filter_button(x4, y, button_width_4, button_height,
+                           FORM_RIGHT_MOST, aggregated, "TOTAL")) {
+        state->settings_changed = true;
+        if (aggregated) {
+            settings.aggregated_columns.erase(aggregate);
+        } else {
+            settings.aggregated_columns.push_back(j);
+        }
+        refresh_results(state);
+    }
     
 }
 
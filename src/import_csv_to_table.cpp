@@ -0,0 +1,248 @@
+//
+//  import_csv_to_table.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "import_csv_to_table.hpp"
+#include "row_bitmap.hpp"
+#include <algorithm>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace Table {
+
+static constexpr size_t BLOCK_SIZE = 64;
+
+static uint64_t special_chars_mask(const char* data, size_t size);
+
+CsvImporter::CsvImporter(std::istream& in) : in(in) {
+    buffer.resize(READ_CHUNK_SIZE);
+    buffer_begin = 0;
+    buffer_end = 0;
+    at_eof = false;
+
+    std::vector<std::vector<std::string>> rows;
+    if (!read_rows(rows, 1)) {
+        throw "Headers not set yet";
+    }
+    headers_ = std::move(rows.front());
+}
+
+bool CsvImporter::read_rows(std::vector<std::vector<std::string>>& rows, int max_rows) {
+    rows.clear();
+
+    while (rows.size() < max_rows) {
+        auto remaining = max_rows - (int)rows.size();
+        buffer_begin += scan_lines(buffer.data() + buffer_begin,
+                                   buffer_end - buffer_begin, remaining, rows);
+        if (rows.size() == max_rows || !fill_buffer()) {
+            break;
+        }
+    }
+
+    return !rows.empty();
+}
+
+// Moves the unread bytes to the front of the buffer and reads more
+// after them. Returns false if there was nothing left to read.
+bool CsvImporter::fill_buffer() {
+    if (at_eof) {
+        return false;
+    }
+
+    auto remaining = buffer_end - buffer_begin;
+    memmove(buffer.data(), buffer.data() + buffer_begin, remaining);
+    buffer_begin = 0;
+    buffer_end = remaining;
+
+    // A single line fills the whole buffer
+    if (buffer_end == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    in.read(buffer.data() + buffer_end, buffer.size() - buffer_end);
+    buffer_end += in.gcount();
+    if (!in) {
+        at_eof = true;
+    }
+    return true;
+}
+
+// Parses up to max_rows complete lines from the start of data, and
+// returns the number of bytes used. The last line is only complete
+// without a newline once the whole input has been read.
+size_t CsvImporter::scan_lines(const char* data, size_t size, int max_rows,
+                               std::vector<std::vector<std::string>>& rows) {
+    CsvLineScanner scanner(data, size, at_eof);
+    for (int added = 0; added < max_rows && scanner.next_line(fields); ++added) {
+        add_row(data, rows);
+    }
+    return scanner.position();
+}
+
+void CsvImporter::add_row(const char* data, std::vector<std::vector<std::string>>& rows) {
+    auto num_cols = (int)fields.size() - 1;
+    if (!headers_.empty() && num_cols != headers_.size()) {
+        throw "Row and header has different number of columns";
+    }
+
+    std::vector<std::string> row(num_cols);
+    for (int j = 0; j < num_cols; ++j) {
+        unescape_csv_field(data + fields[j], data + fields[j + 1] - 1, row[j]);
+    }
+    rows.push_back(std::move(row));
+}
+
+template <typename T>
+static void import_rows(CsvImporter& importer, T& model) {
+    if (importer.headers() != all_headers(&model)) {
+        throw "CSV headers don't match the headers of the table";
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    while (importer.read_rows(rows)) {
+        model.upsert_rows(std::move(rows));
+    }
+}
+
+void import_csv_to_table(CsvImporter& importer, BasicModel& model) {
+    import_rows(importer, model);
+}
+
+void import_csv_to_table(CsvImporter& importer, ColumnarModel& model) {
+    import_rows(importer, model);
+}
+
+void unescape_csv_field(const char* begin, const char* end, std::string& text) {
+    if (begin == end || *begin != '"') {
+        text.assign(begin, end);
+        return;
+    }
+
+    text.clear();
+    auto ch = begin + 1;
+    for (; ch < end && *ch != '"'; ++ch) {
+        if (*ch == '\\' && ch + 1 < end) {
+            ++ch;
+        }
+        text.push_back(*ch);
+    }
+}
+
+CsvLineScanner::CsvLineScanner(const char* data, size_t size, bool at_end) :
+    data(data), size(size), at_end(at_end) {
+    line_start = 0;
+    next_block = 0;
+    mask_base = 0;
+    mask = 0;
+    quoted = false;
+    escaped = SIZE_MAX;
+}
+
+bool CsvLineScanner::next_line(std::vector<size_t>& fields) {
+    fields.clear();
+    fields.push_back(line_start);
+
+    for (;;) {
+        while (mask == 0) {
+            if (next_block >= size) {
+                // The last line of the input may not end in a newline
+                if (at_end && line_start < size) {
+                    end_line(size, fields);
+                    return true;
+                }
+                return false;
+            }
+            mask_base = next_block;
+            mask = special_chars_mask(data + next_block, std::min(BLOCK_SIZE, size - next_block));
+            next_block += BLOCK_SIZE;
+        }
+
+        auto i = mask_base + lowest_bit(mask);
+        mask &= mask - 1;
+
+        if (i == escaped) {
+            continue;
+        }
+
+        auto ch = data[i];
+        if (quoted) {
+            if (ch == '\\') {
+                escaped = i + 1;
+            } else if (ch == '"') {
+                quoted = false;
+            }
+            continue;
+        }
+
+        if (ch == '"') {
+            quoted = true;
+        } else if (ch == ',') {
+            fields.push_back(i + 1);
+        } else if (ch == '\n') {
+            end_line(i, fields);
+            return true;
+        }
+    }
+}
+
+// Ends the line at the newline at `end` (or the end of the input)
+void CsvLineScanner::end_line(size_t end, std::vector<size_t>& fields) {
+    line_start = std::min(end + 1, size);
+    if (end > fields.back() && data[end - 1] == '\r') {
+        --end;
+    }
+    fields.push_back(end + 1);
+}
+
+// Returns a mask with bit k set if data[k] is one of , " \ or newline,
+// for the first `size` (at most 64) bytes of data
+uint64_t special_chars_mask(const char* data, size_t size) {
+#if defined(__AVX2__)
+    if (size == BLOCK_SIZE) {
+        auto match = [](const char* p) {
+            auto chunk = _mm256_loadu_si256((const __m256i*)p);
+            auto hits = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(',')),
+                                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\')),
+                                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))));
+            return (uint64_t)(uint32_t)_mm256_movemask_epi8(hits);
+        };
+        return match(data) | (match(data + 32) << 32);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    if (size == BLOCK_SIZE) {
+        auto match = [](const char* p) {
+            auto chunk = _mm_loadu_si128((const __m128i*)p);
+            auto hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+            return (uint64_t)(uint16_t)_mm_movemask_epi8(hits);
+        };
+        return match(data) | (match(data + 16) << 16) |
+               (match(data + 32) << 32) | (match(data + 48) << 48);
+    }
+#endif
+
+    uint64_t mask = 0;
+    for (size_t k = 0; k < size; ++k) {
+        auto ch = data[k];
+        if (ch == ',' || ch == '"' || ch == '\\' || ch == '\n') {
+            mask |= (uint64_t)1 << k;
+        }
+    }
+    return mask;
+}
+
+}
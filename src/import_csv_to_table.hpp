@@ -0,0 +1,96 @@
+//
+//  import_csv_to_table.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_import_csv_to_table_hpp
+#define ddui_table_import_csv_to_table_hpp
+
+#include <istream>
+#include "model.hpp"
+#include "columnar_model.hpp"
+
+namespace Table {
+
+// Splits CSV in the format that export_table_to_csv() writes into
+// lines, and finds where each field starts. The input is scanned 64
+// bytes at a time for commas, quotes, backslashes and newlines (with
+// AVX2 or SSE2 when the build targets them), so only those bytes are
+// looked at one at a time.
+class CsvLineScanner {
+    public:
+        // The last line of data only counts without a newline when at_end
+        CsvLineScanner(const char* data, size_t size, bool at_end);
+
+        // Fills in the start of every field of the next complete line,
+        // followed by one past the end of the line, as offsets into
+        // data. Returns false when there are no complete lines left.
+        bool next_line(std::vector<size_t>& fields);
+
+        // Start of the first line that next_line hasn't returned
+        size_t position() const {
+            return line_start;
+        }
+
+    private:
+        void end_line(size_t end, std::vector<size_t>& fields);
+
+        const char* data;
+        size_t size;
+        bool at_end;
+        size_t line_start;
+        size_t next_block;
+        size_t mask_base; // offset of bit 0 of mask
+        uint64_t mask; // special characters of the block not looked at yet
+        bool quoted;
+        size_t escaped; // position of a character after a backslash
+};
+
+// Reads CSV in the format that export_table_to_csv() writes, from a
+// stream in large chunks, splitting it with CsvLineScanner. The first
+// line holds the headers.
+class CsvImporter {
+    public:
+        static constexpr int BATCH_ROWS = 4096;
+
+        CsvImporter(std::istream& in);
+        const std::vector<std::string>& headers() {
+            return headers_;
+        }
+
+        // Replaces the contents of `rows` with up to max_rows further
+        // rows. Returns false once the input has no more rows.
+        bool read_rows(std::vector<std::vector<std::string>>& rows,
+                       int max_rows = BATCH_ROWS);
+
+    private:
+        static constexpr size_t READ_CHUNK_SIZE = 1 << 20;
+
+        bool fill_buffer();
+        size_t scan_lines(const char* data, size_t size, int max_rows,
+                          std::vector<std::vector<std::string>>& rows);
+        void add_row(const char* data, std::vector<std::vector<std::string>>& rows);
+
+        std::istream& in;
+        std::vector<char> buffer;
+        size_t buffer_begin, buffer_end;
+        bool at_eof;
+        std::vector<std::string> headers_;
+        std::vector<size_t> fields;
+};
+
+// Reads all remaining rows into the model in batches, replacing rows
+// with a matching key. The headers have to match the model's headers.
+void import_csv_to_table(CsvImporter& importer, BasicModel& model);
+void import_csv_to_table(CsvImporter& importer, ColumnarModel& model);
+
+// Reverses the quoting and escaping of export_table_to_csv(), for the
+// field in [begin, end)
+void unescape_csv_field(const char* begin, const char* end, std::string& text);
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+//
+//  mapped_file.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Table {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+    data_ = NULL;
+    size_ = 0;
+    mapping_handle = NULL;
+
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        throw "Could not open file";
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_handle, &size)) {
+        CloseHandle(file_handle);
+        throw "Could not read file size";
+    }
+    size_ = (size_t)size.QuadPart;
+    if (size_ == 0) {
+        return;
+    }
+
+    mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_handle == NULL) {
+        CloseHandle(file_handle);
+        throw "Could not map file";
+    }
+    data_ = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data_ == NULL) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        throw "Could not map file";
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != NULL) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle != NULL) {
+        CloseHandle(mapping_handle);
+    }
+    CloseHandle(file_handle);
+}
+
+void MappedFile::advise_sequential() {
+}
+
+void MappedFile::advise_random() {
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+    data_ = NULL;
+    size_ = 0;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw "Could not open file";
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw "Could not read file size";
+    }
+    size_ = info.st_size;
+    if (size_ == 0) {
+        close(fd);
+        return;
+    }
+
+    void* mapping = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw "Could not map file";
+    }
+    data_ = (const char*)mapping;
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != NULL) {
+        munmap((void*)data_, size_);
+    }
+}
+
+void MappedFile::advise_sequential() {
+    if (data_ != NULL) {
+        madvise((void*)data_, size_, MADV_SEQUENTIAL);
+    }
+}
+
+void MappedFile::advise_random() {
+    if (data_ != NULL) {
+        madvise((void*)data_, size_, MADV_RANDOM);
+    }
+}
+
+#endif
+
+}
@@ -0,0 +1,47 @@
+//
+//  mapped_file.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_mapped_file_hpp
+#define ddui_table_mapped_file_hpp
+
+#include <string>
+#include <stddef.h>
+
+namespace Table {
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+    public:
+        MappedFile(const std::string& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const {
+            return data_;
+        }
+        size_t size() const {
+            return size_;
+        }
+
+        // Hints to the OS on how the mapping is about to be read
+        void advise_sequential();
+        void advise_random();
+
+    private:
+        const char* data_;
+        size_t size_;
+#ifdef _WIN32
+        void* file_handle;
+        void* mapping_handle;
+#endif
+};
+
+}
+
+#endif
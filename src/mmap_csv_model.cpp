@@ -0,0 +1,113 @@
+//
+//  mmap_csv_model.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "mmap_csv_model.hpp"
+#include "import_csv_to_table.hpp"
+
+namespace Table {
+
+MmapCsvModel::MmapCsvModel(const std::string& path, std::vector<std::string> key) : file(path) {
+    scratch_index = 0;
+
+    auto data = file.data();
+    auto size = file.size();
+
+    file.advise_sequential();
+
+    // Step 1. Read the headers
+    CsvLineScanner scanner(data, size, true);
+    std::vector<size_t> fields;
+    if (!scanner.next_line(fields)) {
+        throw "Headers not set yet";
+    }
+    for (int j = 0; j + 1 < fields.size(); ++j) {
+        std::string header;
+        unescape_csv_field(data + fields[j], data + fields[j + 1] - 1, header);
+        headers.push_back(std::move(header));
+    }
+
+    for (auto& header : key) {
+        auto index = get_header_index(this, header);
+        if (index == -1) {
+            throw "Header used as key is not present in table";
+        }
+        key_.push_back(index);
+    }
+
+    // Step 2. Index all the rows
+    auto num_cols = headers.size();
+    bulk_scratch.resize(num_cols);
+    while (scanner.next_line(fields)) {
+        if (fields.size() != num_cols + 1) {
+            throw "Row and header has different number of columns";
+        }
+
+        auto row_start = fields[0];
+        if (fields.back() - row_start > UINT32_MAX) {
+            throw "Row is too long";
+        }
+
+        row_offsets.push_back(row_start);
+        for (auto field : fields) {
+            field_offsets.push_back(field - row_start);
+        }
+    }
+
+    row_offsets.shrink_to_fit();
+    field_offsets.shrink_to_fit();
+
+    file.advise_random();
+}
+
+const std::string& MmapCsvModel::cell_text(int row, int col) {
+    auto offsets = &field_offsets[row * (headers.size() + 1)];
+    auto row_start = file.data() + row_offsets[row];
+
+    auto& text = scratch[scratch_index];
+    scratch_index = (scratch_index + 1) % SCRATCH_SLOTS;
+    unescape_csv_field(row_start + offsets[col], row_start + offsets[col + 1] - 1, text);
+    return text;
+}
+
+std::string_view MmapCsvModel::cell_view(int row, int col) {
+    auto offsets = &field_offsets[row * (headers.size() + 1)];
+    auto row_start = file.data() + row_offsets[row];
+    auto begin = row_start + offsets[col];
+    auto end = row_start + offsets[col + 1] - 1;
+
+    // Quoted fields have to be unescaped into a scratch string first
+    if (begin != end && *begin == '"') {
+        return cell_text(row, col);
+    }
+    return std::string_view(begin, end - begin);
+}
+
+void MmapCsvModel::cells(int col, int row_begin, int row_end, std::string_view* out) {
+    auto stride = headers.size() + 1;
+    auto data = file.data();
+    auto& scratch = bulk_scratch[col];
+
+    for (int i = row_begin; i < row_end; ++i) {
+        auto offsets = &field_offsets[i * stride];
+        auto begin = data + row_offsets[i] + offsets[col];
+        auto end = data + row_offsets[i] + offsets[col + 1] - 1;
+
+        if (begin != end && *begin == '"') {
+            if (scratch.size() < row_end - row_begin) {
+                scratch.resize(row_end - row_begin);
+            }
+            auto& text = scratch[i - row_begin];
+            unescape_csv_field(begin, end, text);
+            *out++ = text;
+        } else {
+            *out++ = std::string_view(begin, end - begin);
+        }
+    }
+}
+
+}
@@ -0,0 +1,80 @@
+//
+//  mmap_csv_model.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_mmap_csv_model_hpp
+#define ddui_table_mmap_csv_model_hpp
+
+#include "model.hpp"
+#include "mapped_file.hpp"
+
+namespace Table {
+
+// A read-only model over a memory-mapped CSV file, in the format that
+// export_table_to_csv() writes. The first line holds the headers.
+//
+// Opening the file makes one pass over it with CsvLineScanner to find
+// where every row and field starts; cells are only read from the
+// mapping when they are asked for. Resident memory is the size of that
+// index (8 bytes per row and 4 bytes per cell) plus whatever pages the
+// OS keeps cached.
+//
+// Like ColumnarModel, cell_text() materialises cells into a small ring
+// of scratch strings, so a reference stays valid for SCRATCH_SLOTS
+// further calls. cell_view() points straight into the mapping for
+// fields that aren't quoted.
+class MmapCsvModel : public Model {
+    public:
+        MmapCsvModel(const std::string& path,
+                     std::vector<std::string> key = {});
+
+        // Implement Model methods
+        long ref() {
+            return 1; // the file is never reloaded
+        }
+        int columns() {
+            return headers.size();
+        }
+        int rows() {
+            return row_offsets.size();
+        }
+        const std::string& header_text(int col) {
+            return headers[col];
+        }
+        const std::string& cell_text(int row, int col);
+        std::string_view cell_view(int row, int col);
+        void cells(int col, int row_begin, int row_end, std::string_view* out);
+        std::vector<int> key() {
+            return key_;
+        }
+        void set_cell_text(int row, int col, const std::string& text) {
+            throw "MmapCsvModel is read-only";
+        }
+
+    private:
+        static constexpr int SCRATCH_SLOTS = 16;
+
+        MappedFile file;
+        std::vector<std::string> headers;
+        std::vector<int> key_;
+
+        // Field f of row i starts at row_offsets[i] + field_offsets[i * (columns + 1) + f]
+        // and ends one byte before the start of field f + 1. The extra
+        // entry per row marks one past the end of the line.
+        std::vector<uint64_t> row_offsets;
+        std::vector<uint32_t> field_offsets;
+
+        std::string scratch[SCRATCH_SLOTS];
+        int scratch_index;
+
+        // Unescaped quoted fields handed out by cells(), per column
+        std::vector<std::vector<std::string>> bulk_scratch;
+};
+
+}
+
+#endif
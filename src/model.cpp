@@ -7,9 +7,25 @@
 //
 
 #include "model.hpp"
+#include <algorithm>
 
 namespace Table {
 
+void Model::cells(int col, int row_begin, int row_end, std::string_view* out) {
+    if (cells_scratch.size() <= col) {
+        cells_scratch.resize(col + 1);
+    }
+    auto& scratch = cells_scratch[col];
+    if (scratch.size() < row_end - row_begin) {
+        scratch.resize(row_end - row_begin);
+    }
+    for (int i = row_begin; i < row_end; ++i) {
+        auto& text = scratch[i - row_begin];
+        text = cell_text(i, col);
+        out[i - row_begin] = text;
+    }
+}
+
 BasicModel::BasicModel() {
     version_count = 0;
     editable = true;
@@ -18,6 +34,7 @@ BasicModel::BasicModel() {
 BasicModel::BasicModel(std::vector<std::string> headers,
                        std::vector<std::string> key) {
     version_count = 1;
+    change_log.reset(version_count);
     this->headers = std::move(headers);
 
     if (this->headers.empty()) {
@@ -34,44 +51,233 @@ BasicModel::BasicModel(std::vector<std::string> headers,
 }
 
 void BasicModel::insert_row(std::vector<std::string> row) {
-    if (row.size() != headers.size()) {
-        throw "Row and header has different number of columns";
+    check_row_size(row);
+    version_count++;
+
+    ModelDelta delta;
+    auto replaced = upsert_row(std::move(row));
+    if (replaced == -1) {
+        delta.appended_rows = 1;
+    } else {
+        delta.updated_rows.push_back(replaced);
     }
+    change_log.record(version_count, data.size(), std::move(delta));
+}
 
-    version_count++;
+void BasicModel::insert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row_size(row);
+    }
 
+    // Resolve all keys up front, so a conflict leaves the table untouched
+    std::vector<std::string> encoded_keys;
     if (!key_.empty()) {
-        int index = -1;
-        for (int i = 0; i < data.size(); ++i) {
-            bool match = true;
-            for (auto j : key_) {
-                if (data[i][j] != row[j]) {
-                    match = false;
-                    break;
-                }
+        encoded_keys.reserve(rows.size());
+        std::unordered_map<std::string, int> batch_keys;
+        batch_keys.reserve(rows.size());
+        for (auto& row : rows) {
+            auto encoded = encode_key(row, key_);
+            if (key_index.find(encoded) != key_index.end() ||
+                !batch_keys.insert(std::make_pair(encoded, 0)).second) {
+                throw "Row with this key is already present in table";
             }
-            if (match) {
-                index = i;
-                break;
+            encoded_keys.push_back(std::move(encoded));
+        }
+        key_index.reserve(key_index.size() + rows.size());
+    }
+
+    data.reserve(data.size() + rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        if (!key_.empty()) {
+            key_index.insert(std::make_pair(std::move(encoded_keys[i]), (int)data.size()));
+        }
+        data.push_back(std::move(rows[i]));
+    }
+
+    version_count++;
+
+    ModelDelta delta;
+    delta.appended_rows = rows.size();
+    change_log.record(version_count, data.size(), std::move(delta));
+}
+
+void BasicModel::upsert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row_size(row);
+    }
+
+    data.reserve(data.size() + rows.size());
+    if (!key_.empty()) {
+        key_index.reserve(key_index.size() + rows.size());
+    }
+
+    ModelDelta delta;
+    int rows_before = data.size();
+    for (auto& row : rows) {
+        auto replaced = upsert_row(std::move(row));
+        if (replaced != -1 && replaced < rows_before) {
+            delta.updated_rows.push_back(replaced);
+        }
+    }
+    std::sort(delta.updated_rows.begin(), delta.updated_rows.end());
+    delta.updated_rows.erase(std::unique(delta.updated_rows.begin(), delta.updated_rows.end()),
+                             delta.updated_rows.end());
+    delta.appended_rows = data.size() - rows_before;
+
+    version_count++;
+    change_log.record(version_count, data.size(), std::move(delta));
+}
+
+void BasicModel::reconcile(std::vector<std::vector<std::string>> rows) {
+    if (key_.empty()) {
+        throw "Only tables with a key can be reconciled";
+    }
+    for (auto& row : rows) {
+        check_row_size(row);
+    }
+
+    // Join the snapshot against the key index up front, so a duplicate
+    // key leaves the table untouched
+    std::vector<int> matches(rows.size(), -1);     // snapshot row -> existing row
+    std::vector<int> matched_by(data.size(), -1);  // existing row -> snapshot row
+    std::vector<std::unordered_map<std::string, int>::iterator> index_entries(data.size());
+    std::vector<std::string> new_keys;
+    std::unordered_map<std::string, int> batch_keys;
+    for (int k = 0; k < rows.size(); ++k) {
+        auto encoded = encode_key(rows[k], key_);
+        auto lookup = key_index.find(encoded);
+        if (lookup != key_index.end()) {
+            if (matched_by[lookup->second] != -1) {
+                throw "Row with this key is already present in table";
             }
+            matches[k] = lookup->second;
+            matched_by[lookup->second] = k;
+            index_entries[lookup->second] = lookup;
+            continue;
+        }
+        if (!batch_keys.insert(std::make_pair(encoded, 0)).second) {
+            throw "Row with this key is already present in table";
         }
+        new_keys.push_back(std::move(encoded));
+    }
 
-        if (index != -1) {
-            data[index] = std::move(row);
-            return;
+    ModelDelta delta;
+
+    // Update matched rows in place and remove the others, compacting
+    // the surviving rows towards the start. Entries of the key index
+    // stay valid until the index is next inserted into, so moved rows
+    // are renumbered through the entries found above.
+    int output = 0;
+    for (int i = 0; i < data.size(); ++i) {
+        auto k = matched_by[i];
+        if (k == -1) {
+            key_index.erase(encode_key(data[i], key_));
+            delta.removed_rows.push_back(i);
+            continue;
+        }
+        if (data[i] != rows[k]) {
+            data[i] = std::move(rows[k]);
+            delta.updated_rows.push_back(output);
         }
+        if (output != i) {
+            data[output] = std::move(data[i]);
+            index_entries[i]->second = output;
+        }
+        ++output;
+    }
+    data.resize(output);
+
+    // Append the rows with new keys, in snapshot order
+    data.reserve(data.size() + new_keys.size());
+    int new_key = 0;
+    for (int k = 0; k < rows.size(); ++k) {
+        if (matches[k] != -1) {
+            continue;
+        }
+        key_index.insert(std::make_pair(std::move(new_keys[new_key++]), (int)data.size()));
+        data.push_back(std::move(rows[k]));
+    }
+    delta.appended_rows = new_keys.size();
+
+    version_count++;
+    change_log.record(version_count, data.size(), std::move(delta));
+}
+
+void BasicModel::record_cell_update(int row, int col) {
+    ++version_count;
+    ModelDelta delta;
+    delta.updated_cells.push_back(std::make_pair(row, col));
+    change_log.record(version_count, data.size(), std::move(delta));
+}
+
+void BasicModel::check_row_size(const std::vector<std::string>& row) {
+    if (row.size() != headers.size()) {
+        throw "Row and header has different number of columns";
+    }
+}
+
+int BasicModel::upsert_row(std::vector<std::string>&& row) {
+    if (!key_.empty()) {
+        auto encoded = encode_key(row, key_);
+        auto lookup = key_index.find(encoded);
+        if (lookup != key_index.end()) {
+            data[lookup->second] = std::move(row);
+            return lookup->second;
+        }
+        key_index.insert(std::make_pair(std::move(encoded), (int)data.size()));
     }
 
     data.push_back(std::move(row));
+    return -1;
+}
+
+void BasicModel::set_cell_text(int row, int col, const std::string& text) {
+    bool is_key_column = false;
+    for (auto j : key_) {
+        if (j == col) {
+            is_key_column = true;
+            break;
+        }
+    }
+
+    if (!is_key_column) {
+        data[row][col] = text;
+        record_cell_update(row, col);
+        return;
+    }
+
+    // The row moves to a different key, so re-index it. Check that no
+    // other row has the new key first, so a conflict leaves the table
+    // untouched.
+    std::string new_encoded;
+    for (auto j : key_) {
+        append_key_cell(new_encoded, j == col ? text : data[row][j]);
+    }
+    auto conflict = key_index.find(new_encoded);
+    if (conflict != key_index.end() && conflict->second != row) {
+        throw "Row with this key is already present in table";
+    }
+
+    auto lookup = key_index.find(encode_key(data[row], key_));
+    if (lookup != key_index.end() && lookup->second == row) {
+        key_index.erase(lookup);
+    }
+    data[row][col] = text;
+    key_index.insert(std::make_pair(std::move(new_encoded), row));
+    record_cell_update(row, col);
 }
 
 void BasicModel::replace_content(std::vector<std::string> headers,
                                  std::vector<std::vector<std::string>> data) {
     if (!key_.empty()) {
-        printf("Only allowed to use BasicModel::replace_content() on tables with no key.\n");
-        exit(1);
+        if (headers != this->headers) {
+            throw "Headers of a table with a key can't be replaced";
+        }
+        reconcile(std::move(data));
+        return;
     }
     version_count++;
+    change_log.reset(version_count);
     this->headers = std::move(headers);
     this->data = std::move(data);
 }
@@ -100,4 +306,26 @@ std::vector<std::string> all_headers(Model* model) {
     return vector;
 }
 
+void append_key_cell(std::string& encoded, std::string_view cell) {
+    auto length = (unsigned)cell.size();
+    encoded.append((const char*)&length, sizeof(length));
+    encoded.append(cell);
+}
+
+std::string encode_key(const std::vector<std::string>& row, const std::vector<int>& key) {
+    std::string encoded;
+    for (auto j : key) {
+        append_key_cell(encoded, row[j]);
+    }
+    return encoded;
+}
+
+std::string encode_key(Model* model, int row, const std::vector<int>& key) {
+    std::string encoded;
+    for (auto j : key) {
+        append_key_cell(encoded, model->cell_text(row, j));
+    }
+    return encoded;
+}
+
 }
@@ -11,6 +11,10 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <stdint.h>
+#include "model_delta.hpp"
 #include <ddui/views/Menu>
 
 namespace Table {
@@ -21,8 +25,20 @@ struct Model {
         USE_DEFAULT_RENDER
     };
 
+    enum ColumnType {
+        COLUMN_STRING,
+        COLUMN_INT64,
+        COLUMN_DOUBLE,
+        COLUMN_TIMESTAMP // microseconds since the Unix epoch, UTC
+    };
+
     virtual ~Model() = default;
 
+    virtual void begin_update() {
+        // called by the view once per frame, before it reads anything
+        // else from the model. Models that are written from other
+        // threads can use it to pick up the data to show for the frame.
+    };
     virtual long ref() = 0; // returns a number that changes
                             // when the underlying data of the
                             // model changes.
@@ -30,6 +46,20 @@ struct Model {
     virtual int rows() = 0;
     virtual const std::string& header_text(int col) = 0;
     virtual const std::string& cell_text(int row, int col) = 0;
+    virtual std::string_view cell_view(int row, int col) {
+        // as a default, view the text from cell_text(). Models that
+        // don't keep a std::string per cell should override this to
+        // avoid materialising one. A view stays valid for as long as
+        // the reference from cell_text() would.
+        return cell_text(row, col);
+    };
+    // Fetches rows [row_begin, row_end) of a column in one call. The
+    // views stay valid until the next call to cells() for the same
+    // column, or until the model changes. As a default, the cells are
+    // copied from cell_text() into scratch strings kept per column, as
+    // cell_text() may hand out the same string for every cell. Models
+    // whose cells can be viewed in place should override it.
+    virtual void cells(int col, int row_begin, int row_end, std::string_view* out);
     virtual std::vector<int> key() = 0;
     virtual bool cell_editable(int row, int col) {
         // as a default, cells are not editable
@@ -40,6 +70,63 @@ struct Model {
         // as a default, we have no custom rendering
         return USE_DEFAULT_RENDER;
     };
+
+    // Dictionary encoding: a column may be stored as a table of distinct
+    // values plus a dense id per cell. Equal ids always mean equal text,
+    // so filtering and grouping can work on ids instead of strings. The
+    // dictionary may hold values that no cell refers to anymore.
+    virtual bool column_has_dictionary(int col) {
+        // as a default, columns are not dictionary encoded
+        return false;
+    };
+    virtual int dictionary_size(int col) {
+        return 0;
+    };
+    virtual const std::string& dictionary_text(int col, uint32_t id) {
+        throw "Column is not dictionary encoded";
+    };
+    virtual uint32_t cell_id(int row, int col) {
+        throw "Column is not dictionary encoded";
+    };
+    virtual void cell_ids(int col, int row_begin, int row_end, uint32_t* out) {
+        for (int i = row_begin; i < row_end; ++i) {
+            out[i - row_begin] = cell_id(i, col);
+        }
+    };
+
+    // Typed columns: a model may keep a column in parsed form, which
+    // lets sorting compare native values. cell_int64 serves INT64 and
+    // TIMESTAMP columns, cell_double serves DOUBLE columns. cell_text
+    // still returns the formatted text (see typed_value.hpp).
+    virtual ColumnType column_type(int col) {
+        // as a default, all columns are strings
+        return COLUMN_STRING;
+    };
+    virtual int64_t cell_int64(int row, int col) {
+        throw "Column is not an integer or timestamp column";
+    };
+    virtual double cell_double(int row, int col) {
+        throw "Column is not a double column";
+    };
+
+    // Change deltas: fills in how the model changed since since_ref.
+    // Updated rows and cells are numbered after the change and never
+    // include appended rows. Returns false when the model can't tell
+    // (the default), in which case the view rebuilds everything.
+    virtual bool delta(long since_ref, ModelDelta* delta) {
+        return false;
+    };
+
+    // Concurrent reads: whether cells() and cell_ids() can be called for
+    // this column from several threads at once, for disjoint row ranges
+    // and while the model isn't being modified. Models that hand out
+    // views of shared scratch strings must keep the default.
+    virtual bool concurrent_cells(int col) {
+        return false;
+    };
+
+    private:
+        std::vector<std::vector<std::string>> cells_scratch; // for the default cells()
 };
 
 class BasicModel : public Model {
@@ -48,8 +135,21 @@ class BasicModel : public Model {
         BasicModel(std::vector<std::string> headers,
                    std::vector<std::string> key);
         void insert_row(std::vector<std::string> row);
+
+        // Batched versions of insert_row. Both bump ref() once for the
+        // whole batch. insert_rows requires that none of the keys are
+        // present yet, whereas upsert_rows replaces rows with a matching
+        // key (which is what insert_row does for a single row).
+        void insert_rows(std::vector<std::vector<std::string>> rows);
+        void upsert_rows(std::vector<std::vector<std::string>> rows);
         void replace_content(std::vector<std::string> headers,
                              std::vector<std::vector<std::string>> data);
+
+        // Makes the table hold exactly `rows`, matching them to the
+        // existing rows by key. Changed rows are updated in place, rows
+        // with new keys are appended and rows whose key is missing are
+        // removed, all in a single change to ref(). Only for keyed tables.
+        void reconcile(std::vector<std::vector<std::string>> rows);
         bool editable;
 
         // Implement Model methods
@@ -68,27 +168,90 @@ class BasicModel : public Model {
         const std::string& cell_text(int row, int col) {
             return data[row][col];
         }
+        std::string_view cell_view(int row, int col) {
+            return data[row][col];
+        }
+        void cells(int col, int row_begin, int row_end, std::string_view* out) {
+            for (int i = row_begin; i < row_end; ++i) {
+                *out++ = data[i][col];
+            }
+        }
         std::vector<int> key() {
             return key_;
         }
         bool cell_editable(int row, int col) {
             return editable;
         }
-        void set_cell_text(int row, int col, const std::string& text) {
-            data[row][col] = text;
-            ++version_count;
+        void set_cell_text(int row, int col, const std::string& text);
+        bool delta(long since_ref, ModelDelta* delta) {
+            return change_log.collect(since_ref, delta);
+        }
+        bool concurrent_cells(int col) {
+            return true;
         }
 
     private:
+        void check_row_size(const std::vector<std::string>& row);
+        int upsert_row(std::vector<std::string>&& row);
+        void record_cell_update(int row, int col);
+
         int version_count; // increments when state is changed
         std::vector<std::string> headers;
         std::vector<std::vector<std::string>> data;
         std::vector<int> key_;
+        std::unordered_map<std::string, int> key_index; // encoded key -> row
+        ChangeLog change_log;
 };
 
 int get_header_index(Model* model, std::string header);
 std::vector<std::string> all_headers(Model* model);
 
+// Call fn(row, value) for every cell of a column, fetching the cells in
+// chunks with Model::cells() (or Model::cell_ids() for the id variant)
+// so that a column scan is a tight loop over contiguous values.
+constexpr int CELL_CHUNK_SIZE = 1024;
+
+template <typename Fn>
+void for_each_cell(Model& model, int col, int row_begin, int row_end, Fn fn) {
+    std::string_view chunk[CELL_CHUNK_SIZE];
+    for (int begin = row_begin; begin < row_end; begin += CELL_CHUNK_SIZE) {
+        auto end = begin + CELL_CHUNK_SIZE < row_end ? begin + CELL_CHUNK_SIZE : row_end;
+        model.cells(col, begin, end, chunk);
+        for (int i = begin; i < end; ++i) {
+            fn(i, chunk[i - begin]);
+        }
+    }
+}
+
+template <typename Fn>
+void for_each_cell(Model& model, int col, Fn fn) {
+    for_each_cell(model, col, 0, model.rows(), fn);
+}
+
+template <typename Fn>
+void for_each_cell_id(Model& model, int col, int row_begin, int row_end, Fn fn) {
+    uint32_t chunk[CELL_CHUNK_SIZE];
+    for (int begin = row_begin; begin < row_end; begin += CELL_CHUNK_SIZE) {
+        auto end = begin + CELL_CHUNK_SIZE < row_end ? begin + CELL_CHUNK_SIZE : row_end;
+        model.cell_ids(col, begin, end, chunk);
+        for (int i = begin; i < end; ++i) {
+            fn(i, chunk[i - begin]);
+        }
+    }
+}
+
+template <typename Fn>
+void for_each_cell_id(Model& model, int col, Fn fn) {
+    for_each_cell_id(model, col, 0, model.rows(), fn);
+}
+
+// Packs the key cells of a row into a single string that can be
+// used to look the row up in a hash index. Each cell is length-
+// prefixed, so different key tuples never encode the same way.
+std::string encode_key(const std::vector<std::string>& row, const std::vector<int>& key);
+std::string encode_key(Model* model, int row, const std::vector<int>& key);
+void append_key_cell(std::string& encoded, std::string_view cell);
+
 }
 
 #endif
@@ -0,0 +1,159 @@
+//
+//  model_delta.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "model_delta.hpp"
+#include <algorithm>
+
+namespace Table {
+
+// Beyond this many recorded rows and cells, the oldest entries are
+// dropped and views that are further behind do a full rebuild.
+static constexpr size_t MAX_RECORDED_SIZE = 1 << 16;
+
+static size_t delta_size(const ModelDelta& delta) {
+    return 1 + delta.removed_rows.size() + delta.updated_rows.size() + delta.updated_cells.size();
+}
+
+ChangeLog::ChangeLog() {
+    base_ref = 0;
+    recorded_size = 0;
+}
+
+void ChangeLog::reset(long ref) {
+    base_ref = ref;
+    entries.clear();
+    recorded_size = 0;
+}
+
+void ChangeLog::record(long ref, int rows, ModelDelta delta) {
+    recorded_size += delta_size(delta);
+    entries.push_back(Entry { ref, rows, std::move(delta) });
+
+    while (recorded_size > MAX_RECORDED_SIZE && entries.size() > 1) {
+        recorded_size -= delta_size(entries.front().delta);
+        base_ref = entries.front().ref;
+        entries.pop_front();
+    }
+}
+
+bool ChangeLog::collect(long since_ref, ModelDelta* delta) {
+    if (since_ref < base_ref) {
+        return false;
+    }
+
+    *delta = ModelDelta();
+
+    int rows = -1;
+    for (auto& entry : entries) {
+        if (entry.ref <= since_ref) {
+            continue;
+        }
+        if (rows == -1) {
+            *delta = entry.delta;
+        } else {
+            compose_deltas(*delta, entry.delta, rows);
+        }
+        rows = entry.rows;
+    }
+
+    return true;
+}
+
+// Maps a row numbered after `delta` back onto its number before it.
+// Only valid for rows that survived, i.e. were not appended.
+static std::vector<int> unmap_surviving_rows(const std::vector<int>& removed_rows,
+                                             const std::vector<int>& rows) {
+    std::vector<int> output;
+    output.reserve(rows.size());
+
+    // Walk both sorted lists, counting the removed rows we skip over
+    int skipped = 0;
+    for (auto row : rows) {
+        while (skipped < removed_rows.size() && removed_rows[skipped] <= row + skipped) {
+            ++skipped;
+        }
+        output.push_back(row + skipped);
+    }
+
+    return output;
+}
+
+int map_row_through_delta(const ModelDelta& delta, int row) {
+    auto& removed = delta.removed_rows;
+    auto lookup = std::lower_bound(removed.begin(), removed.end(), row);
+    if (lookup != removed.end() && *lookup == row) {
+        return -1;
+    }
+    return row - (int)(lookup - removed.begin());
+}
+
+void compose_deltas(ModelDelta& delta, const ModelDelta& next, int rows) {
+    auto surviving = rows - delta.appended_rows;
+
+    // Rows that `next` removes from the surviving region are removed
+    // rows of the combined delta; removed appended rows just cancel out
+    std::vector<int> next_removed_surviving;
+    int cancelled_appends = 0;
+    for (auto row : next.removed_rows) {
+        if (row < surviving) {
+            next_removed_surviving.push_back(row);
+        } else {
+            ++cancelled_appends;
+        }
+    }
+
+    // Updates from the first delta carry through the second one
+    std::vector<int> updated_rows;
+    for (auto row : delta.updated_rows) {
+        auto mapped = map_row_through_delta(next, row);
+        if (mapped != -1) {
+            updated_rows.push_back(mapped);
+        }
+    }
+    std::vector<std::pair<int, int>> updated_cells;
+    for (auto& cell : delta.updated_cells) {
+        auto mapped = map_row_through_delta(next, cell.first);
+        if (mapped != -1) {
+            updated_cells.push_back(std::make_pair(mapped, cell.second));
+        }
+    }
+
+    auto unmapped = unmap_surviving_rows(delta.removed_rows, next_removed_surviving);
+    std::vector<int> removed_rows;
+    removed_rows.reserve(delta.removed_rows.size() + unmapped.size());
+    std::merge(delta.removed_rows.begin(), delta.removed_rows.end(),
+               unmapped.begin(), unmapped.end(), std::back_inserter(removed_rows));
+
+    delta.removed_rows = std::move(removed_rows);
+    delta.appended_rows = delta.appended_rows - cancelled_appends + next.appended_rows;
+
+    // Updates from the second delta to rows appended by either delta
+    // are covered by the append
+    auto rows_after = rows - (int)next.removed_rows.size() + next.appended_rows;
+    auto surviving_after = rows_after - delta.appended_rows;
+    for (auto row : next.updated_rows) {
+        if (row < surviving_after) {
+            updated_rows.push_back(row);
+        }
+    }
+    for (auto& cell : next.updated_cells) {
+        if (cell.first < surviving_after) {
+            updated_cells.push_back(cell);
+        }
+    }
+
+    std::sort(updated_rows.begin(), updated_rows.end());
+    updated_rows.erase(std::unique(updated_rows.begin(), updated_rows.end()), updated_rows.end());
+    std::sort(updated_cells.begin(), updated_cells.end());
+    updated_cells.erase(std::unique(updated_cells.begin(), updated_cells.end()), updated_cells.end());
+
+    delta.updated_rows = std::move(updated_rows);
+    delta.updated_cells = std::move(updated_cells);
+}
+
+}
@@ -0,0 +1,63 @@
+//
+//  model_delta.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_model_delta_hpp
+#define ddui_table_model_delta_hpp
+
+#include <vector>
+#include <deque>
+#include <utility>
+#include <stddef.h>
+
+namespace Table {
+
+// Describes how a model changed between two refs. Models only ever
+// append rows at the end, and removing rows keeps the remaining rows
+// in their order, so the rows that survive map onto the new rows in
+// order, followed by the appended rows.
+struct ModelDelta {
+    std::vector<int> removed_rows;  // sorted, numbered before the change
+    int appended_rows = 0;          // rows added at the end
+    std::vector<int> updated_rows;  // any cell may have changed
+    std::vector<std::pair<int, int>> updated_cells; // (row, col)
+};
+
+// Keeps the deltas of the most recent changes to a model, so that the
+// model can implement Model::delta(). Each change that bumps the ref
+// must either be recorded, or reset the log (for changes that can't
+// be described as a delta, like replacing the headers).
+class ChangeLog {
+    public:
+        ChangeLog();
+        void reset(long ref);
+        void record(long ref, int rows, ModelDelta delta);
+        bool collect(long since_ref, ModelDelta* delta);
+
+    private:
+        struct Entry {
+            long ref;
+            int rows; // number of rows after the change
+            ModelDelta delta;
+        };
+
+        long base_ref; // oldest ref a delta can be collected from
+        std::deque<Entry> entries;
+        size_t recorded_size;
+};
+
+// Folds `next` into `delta`, where `rows` is the number of rows after
+// `delta` and before `next`.
+void compose_deltas(ModelDelta& delta, const ModelDelta& next, int rows);
+
+// Maps a row numbered before the delta onto its number after it.
+// Returns -1 if the row was removed.
+int map_row_through_delta(const ModelDelta& delta, int row);
+
+}
+
+#endif
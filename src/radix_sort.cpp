@@ -0,0 +1,179 @@
+//
+//  radix_sort.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "radix_sort.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <string.h>
+
+namespace Table {
+
+static constexpr size_t ENTRIES_PER_TASK = 1 << 16;
+static constexpr size_t MIN_RADIX_SIZE = 1 << 8; // smaller inputs use std::stable_sort
+
+typedef std::function<void(SortEntry* begin, SortEntry* end)> SortTies;
+
+static void sort_bucket(SortEntry* data, SortEntry* scratch, size_t size, int shift,
+                        const SortTies& sort_ties);
+static void sort_tie_runs(SortEntry* data, size_t size, const SortTies& sort_ties);
+
+void radix_sort(std::vector<SortEntry>& entries, const SortTies& sort_ties) {
+    auto size = entries.size();
+    if (size < ENTRIES_PER_TASK) {
+        std::vector<SortEntry> scratch(size);
+        sort_bucket(entries.data(), scratch.data(), size, 64, sort_ties);
+        return;
+    }
+
+    auto& pool = WorkerPool::shared();
+    auto num_tasks = (int)((size + ENTRIES_PER_TASK - 1) / ENTRIES_PER_TASK);
+    auto task_range = [&](int k, size_t* begin, size_t* end) {
+        *begin = k * ENTRIES_PER_TASK;
+        *end = std::min(*begin + ENTRIES_PER_TASK, size);
+    };
+
+    // Step 1. Find the most significant byte in which the keys differ
+    std::vector<uint64_t> any_set(num_tasks, 0), all_set(num_tasks, ~(uint64_t)0);
+    pool.parallel_for(num_tasks, [&](int k) {
+        size_t begin, end;
+        task_range(k, &begin, &end);
+        for (auto i = begin; i < end; ++i) {
+            any_set[k] |= entries[i].key;
+            all_set[k] &= entries[i].key;
+        }
+    });
+    uint64_t any_key_set = 0, all_keys_set = ~(uint64_t)0;
+    for (int k = 0; k < num_tasks; ++k) {
+        any_key_set |= any_set[k];
+        all_keys_set &= all_set[k];
+    }
+    auto differing = any_key_set ^ all_keys_set;
+    if (differing == 0) {
+        sort_tie_runs(entries.data(), size, sort_ties);
+        return;
+    }
+    int shift = 56;
+    while ((differing >> shift) == 0) {
+        shift -= 8;
+    }
+
+    // Step 2. Scatter the entries into buckets by that byte. Each task
+    // writes its entries of a bucket after those of earlier tasks, so
+    // the order of equal keys is kept.
+    std::vector<size_t> counts(num_tasks * 256, 0);
+    pool.parallel_for(num_tasks, [&](int k) {
+        size_t begin, end;
+        task_range(k, &begin, &end);
+        auto task_counts = &counts[k * 256];
+        for (auto i = begin; i < end; ++i) {
+            ++task_counts[(entries[i].key >> shift) & 0xff];
+        }
+    });
+
+    std::vector<size_t> bucket_begin(257);
+    size_t position = 0;
+    for (int b = 0; b < 256; ++b) {
+        bucket_begin[b] = position;
+        for (int k = 0; k < num_tasks; ++k) {
+            auto count = counts[k * 256 + b];
+            counts[k * 256 + b] = position;
+            position += count;
+        }
+    }
+    bucket_begin[256] = position;
+
+    std::vector<SortEntry> scattered(size);
+    pool.parallel_for(num_tasks, [&](int k) {
+        size_t begin, end;
+        task_range(k, &begin, &end);
+        auto task_positions = &counts[k * 256];
+        for (auto i = begin; i < end; ++i) {
+            scattered[task_positions[(entries[i].key >> shift) & 0xff]++] = entries[i];
+        }
+    });
+
+    // Step 3. Sort each bucket on the lower bytes, using the original
+    // array as scratch space
+    pool.parallel_for(256, [&](int b) {
+        auto begin = bucket_begin[b];
+        sort_bucket(&scattered[begin], &entries[begin], bucket_begin[b + 1] - begin, shift, sort_ties);
+    });
+
+    entries.swap(scattered);
+}
+
+// Sorts the entries on the bytes of their key below `shift`, leaving
+// the result in data
+void sort_bucket(SortEntry* data, SortEntry* scratch, size_t size, int shift,
+                 const SortTies& sort_ties) {
+    if (size < 2) {
+        return;
+    }
+
+    auto mask = (shift == 64 ? ~(uint64_t)0 : ((uint64_t)1 << shift) - 1);
+    if (size < MIN_RADIX_SIZE) {
+        std::stable_sort(data, data + size, [&](const SortEntry& l, const SortEntry& r) {
+            return (l.key & mask) < (r.key & mask);
+        });
+        sort_tie_runs(data, size, sort_ties);
+        return;
+    }
+
+    uint64_t any_set = 0, all_set = ~(uint64_t)0;
+    for (size_t i = 0; i < size; ++i) {
+        any_set |= data[i].key;
+        all_set &= data[i].key;
+    }
+    auto differing = (any_set ^ all_set) & mask;
+
+    // One counting pass per byte that differs, least significant first
+    auto source = data;
+    auto target = scratch;
+    for (int byte_shift = 0; byte_shift < shift; byte_shift += 8) {
+        if (((differing >> byte_shift) & 0xff) == 0) {
+            continue;
+        }
+
+        size_t offsets[256] = { 0 };
+        for (size_t i = 0; i < size; ++i) {
+            ++offsets[(source[i].key >> byte_shift) & 0xff];
+        }
+        size_t position = 0;
+        for (int b = 0; b < 256; ++b) {
+            auto count = offsets[b];
+            offsets[b] = position;
+            position += count;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            target[offsets[(source[i].key >> byte_shift) & 0xff]++] = source[i];
+        }
+        std::swap(source, target);
+    }
+    if (source != data) {
+        memcpy(data, source, size * sizeof(SortEntry));
+    }
+
+    sort_tie_runs(data, size, sort_ties);
+}
+
+void sort_tie_runs(SortEntry* data, size_t size, const SortTies& sort_ties) {
+    if (!sort_ties) {
+        return;
+    }
+    size_t run_begin = 0;
+    for (size_t i = 1; i <= size; ++i) {
+        if (i == size || data[i].key != data[run_begin].key) {
+            if (i - run_begin > 1) {
+                sort_ties(data + run_begin, data + i);
+            }
+            run_begin = i;
+        }
+    }
+}
+
+}
@@ -0,0 +1,36 @@
+//
+//  radix_sort.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_radix_sort_hpp
+#define ddui_table_radix_sort_hpp
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+namespace Table {
+
+struct SortEntry {
+    uint64_t key;
+    int row;
+};
+
+// Stably sorts entries by key, spreading the work over the shared
+// WorkerPool. The entries are first split on the most significant byte
+// in which keys differ, then each part is sorted on the remaining bytes
+// with a least significant digit radix sort.
+//
+// Afterwards, every run of two or more entries with equal keys is
+// handed to sort_ties (if set), which may reorder the run. Runs are
+// handed over from several threads at once.
+void radix_sort(std::vector<SortEntry>& entries,
+                const std::function<void(SortEntry* begin, SortEntry* end)>& sort_ties);
+
+}
+
+#endif
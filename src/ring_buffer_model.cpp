@@ -0,0 +1,193 @@
+//
+//  ring_buffer_model.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "ring_buffer_model.hpp"
+#include <algorithm>
+
+namespace Table {
+
+RingBufferModel::RingBufferModel(std::vector<std::string> headers,
+                                 std::vector<std::string> key,
+                                 int capacity) {
+    version_count = 1;
+    change_log.reset(version_count);
+    editable = false;
+    this->headers = std::move(headers);
+    this->capacity = capacity;
+    first_seq = 0;
+    next_seq = 0;
+
+    if (this->headers.empty()) {
+        throw "Headers not set yet";
+    }
+    if (capacity <= 0) {
+        throw "Capacity of RingBufferModel must be positive";
+    }
+
+    for (auto& header : key) {
+        auto index = get_header_index(this, header);
+        if (index == -1) {
+            throw "Header used as key is not present in table";
+        }
+        this->key_.push_back(index);
+    }
+}
+
+void RingBufferModel::insert_row(std::vector<std::string> row) {
+    check_row_size(row);
+
+    auto rows_before = rows();
+    auto first_before = first_seq;
+    auto next_before = next_seq;
+    std::vector<int64_t> updated;
+    upsert_row(row, updated);
+    record_batch(rows_before, first_before, next_before, updated);
+}
+
+void RingBufferModel::upsert_rows(std::vector<std::vector<std::string>> rows) {
+    for (auto& row : rows) {
+        check_row_size(row);
+    }
+
+    auto rows_before = this->rows();
+    auto first_before = first_seq;
+    auto next_before = next_seq;
+    std::vector<int64_t> updated;
+    for (auto& row : rows) {
+        upsert_row(row, updated);
+    }
+    record_batch(rows_before, first_before, next_before, updated);
+}
+
+void RingBufferModel::cells(int col, int row_begin, int row_end, std::string_view* out) {
+    for (int i = row_begin; i < row_end; ++i) {
+        *out++ = slot(first_seq + i)[col];
+    }
+}
+
+void RingBufferModel::set_cell_text(int row, int col, const std::string& text) {
+    auto seq = first_seq + row;
+    auto& cells = slot(seq);
+
+    bool is_key_column = false;
+    for (auto j : key_) {
+        if (j == col) {
+            is_key_column = true;
+            break;
+        }
+    }
+
+    if (is_key_column) {
+        // The row moves to a different key, so re-index it. Check that
+        // no other row has the new key first, so a conflict leaves the
+        // table untouched.
+        std::string new_encoded;
+        for (auto j : key_) {
+            append_key_cell(new_encoded, j == col ? text : cells[j]);
+        }
+        auto conflict = key_index.find(new_encoded);
+        if (conflict != key_index.end() && conflict->second != seq) {
+            throw "Row with this key is already present in table";
+        }
+
+        auto lookup = key_index.find(encode_key(cells, key_));
+        if (lookup != key_index.end() && lookup->second == seq) {
+            key_index.erase(lookup);
+        }
+        cells[col] = text;
+        key_index.insert(std::make_pair(std::move(new_encoded), seq));
+    } else {
+        cells[col] = text;
+    }
+
+    ++version_count;
+    ModelDelta delta;
+    delta.updated_cells.push_back(std::make_pair(row, col));
+    change_log.record(version_count, rows(), std::move(delta));
+}
+
+void RingBufferModel::check_row_size(const std::vector<std::string>& row) {
+    if (row.size() != headers.size()) {
+        throw "Row and header has different number of columns";
+    }
+}
+
+void RingBufferModel::evict_oldest() {
+    if (!key_.empty()) {
+        auto lookup = key_index.find(encode_key(slot(first_seq), key_));
+        if (lookup != key_index.end() && lookup->second == first_seq) {
+            key_index.erase(lookup);
+        }
+    }
+    ++first_seq;
+}
+
+void RingBufferModel::upsert_row(std::vector<std::string>& row, std::vector<int64_t>& updated) {
+    std::string encoded;
+    if (!key_.empty()) {
+        encoded = encode_key(row, key_);
+        auto lookup = key_index.find(encoded);
+        if (lookup != key_index.end()) {
+            auto& cells = slot(lookup->second);
+            for (int j = 0; j < cells.size(); ++j) {
+                cells[j] = row[j];
+            }
+            updated.push_back(lookup->second);
+            return;
+        }
+    }
+
+    if (rows() == capacity) {
+        evict_oldest();
+    }
+
+    // Copy into the slot's strings rather than moving, so that their
+    // buffers get reused once the ring has wrapped around
+    if (slots.size() < capacity) {
+        slots.push_back(std::move(row));
+    } else {
+        auto& cells = slot(next_seq);
+        for (int j = 0; j < cells.size(); ++j) {
+            cells[j] = row[j];
+        }
+    }
+
+    if (!key_.empty()) {
+        key_index.insert(std::make_pair(std::move(encoded), next_seq));
+    }
+    ++next_seq;
+}
+
+void RingBufferModel::record_batch(int rows_before, int64_t first_before, int64_t next_before,
+                                   const std::vector<int64_t>& updated) {
+    ModelDelta delta;
+
+    // Evictions always remove a prefix of the rows held before the batch
+    auto evicted = (int)std::min<int64_t>(first_seq - first_before, rows_before);
+    delta.removed_rows.reserve(evicted);
+    for (int i = 0; i < evicted; ++i) {
+        delta.removed_rows.push_back(i);
+    }
+
+    // Rows appended and then evicted within the batch never show up
+    delta.appended_rows = (int)(next_seq - std::max(next_before, first_seq));
+
+    for (auto seq : updated) {
+        if (seq >= first_seq && seq < next_before) {
+            delta.updated_rows.push_back((int)(seq - first_seq));
+        }
+    }
+    std::sort(delta.updated_rows.begin(), delta.updated_rows.end());
+    delta.updated_rows.erase(std::unique(delta.updated_rows.begin(), delta.updated_rows.end()),
+                             delta.updated_rows.end());
+
+    ++version_count;
+    change_log.record(version_count, rows(), std::move(delta));
+}
+
+}
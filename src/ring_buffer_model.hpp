@@ -0,0 +1,93 @@
+//
+//  ring_buffer_model.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_ring_buffer_model_hpp
+#define ddui_table_ring_buffer_model_hpp
+
+#include "model.hpp"
+
+namespace Table {
+
+// A model holding at most `capacity` rows, for tailing a stream of
+// events. Once full, each new row evicts the oldest one, and its
+// storage is reused for the new row. Evictions are reported through
+// delta() as removed rows at the start of the table.
+class RingBufferModel : public Model {
+    public:
+        RingBufferModel(std::vector<std::string> headers,
+                        std::vector<std::string> key,
+                        int capacity);
+
+        // Both replace the row with a matching key, if it's still held.
+        // upsert_rows bumps ref() once for the whole batch.
+        void insert_row(std::vector<std::string> row);
+        void upsert_rows(std::vector<std::vector<std::string>> rows);
+        bool editable;
+
+        // Implement Model methods
+        long ref() {
+            return version_count;
+        }
+        int columns() {
+            return headers.size();
+        }
+        int rows() {
+            return (int)(next_seq - first_seq);
+        }
+        const std::string& header_text(int col) {
+            return headers[col];
+        }
+        const std::string& cell_text(int row, int col) {
+            return slot(first_seq + row)[col];
+        }
+        std::string_view cell_view(int row, int col) {
+            return slot(first_seq + row)[col];
+        }
+        void cells(int col, int row_begin, int row_end, std::string_view* out);
+        std::vector<int> key() {
+            return key_;
+        }
+        bool cell_editable(int row, int col) {
+            return editable;
+        }
+        void set_cell_text(int row, int col, const std::string& text);
+        bool delta(long since_ref, ModelDelta* delta) {
+            return change_log.collect(since_ref, delta);
+        }
+        bool concurrent_cells(int col) {
+            return true;
+        }
+
+    private:
+        // Rows are numbered by a sequence number that counts every row
+        // ever appended. The row with sequence number s lives in slot
+        // s % capacity, and row i of the table has sequence first_seq + i.
+        std::vector<std::string>& slot(int64_t seq) {
+            return slots[seq % capacity];
+        }
+
+        void check_row_size(const std::vector<std::string>& row);
+        void evict_oldest();
+        void upsert_row(std::vector<std::string>& row, std::vector<int64_t>& updated);
+        void record_batch(int rows_before, int64_t first_before, int64_t next_before,
+                          const std::vector<int64_t>& updated);
+
+        int version_count; // increments when state is changed
+        int capacity;
+        std::vector<std::string> headers;
+        std::vector<std::vector<std::string>> slots;
+        int64_t first_seq; // oldest row still held
+        int64_t next_seq;  // sequence number of the next row appended
+        std::vector<int> key_;
+        std::unordered_map<std::string, int64_t> key_index; // encoded key -> seq
+        ChangeLog change_log;
+};
+
+}
+
+#endif
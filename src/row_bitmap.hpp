@@ -0,0 +1,61 @@
+//
+//  row_bitmap.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_row_bitmap_hpp
+#define ddui_table_row_bitmap_hpp
+
+#include <vector>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Table {
+
+// A set of rows as a word-packed bitset: row i is bit i % 64 of
+// word i / 64. Bits past the last row are always zero.
+typedef std::vector<uint64_t> RowBitmap;
+
+inline int bitmap_words(int rows) {
+    return (rows + 63) / 64;
+}
+
+inline bool row_is_set(const RowBitmap& bitmap, int row) {
+    return (bitmap[row / 64] >> (row % 64)) & 1;
+}
+
+inline void set_row(RowBitmap& bitmap, int row) {
+    bitmap[row / 64] |= (uint64_t)1 << (row % 64);
+}
+
+inline void clear_row(RowBitmap& bitmap, int row) {
+    bitmap[row / 64] &= ~((uint64_t)1 << (row % 64));
+}
+
+inline int lowest_bit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int count_bits(uint64_t word) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+}
+
+#endif
@@ -7,179 +7,1535 @@
 //
 
 #include "settings.hpp"
-#include <functional>
+#include <string.h>
 #include <algorithm>
+#include <functional>
+#include <limits.h>
 #include "alphacmp.hpp"
+#include "worker_pool.hpp"
+#include "radix_sort.hpp"
+#include "typed_value.hpp"
 
 namespace Table {
 
-static Results apply_settings_grouped(Model& model, Settings& settings);
+// Rows per task when splitting work over the WorkerPool. A multiple
+// of 64, so that each task writes whole words of a RowBitmap.
+static constexpr int ROWS_PER_TASK = 1 << 16;
 
-Results apply_settings(Model& model, Settings& settings) {
+// Group of a row that doesn't pass the filters, in ResultsCache::row_groups
+static constexpr uint32_t NO_GROUP = ~(uint32_t)0;
 
-    if (settings.grouped_column != -1) {
-        return apply_settings_grouped(model, settings);
-    }
+// Rows changed in a group that are placed one by one with a binary
+// search. Beyond this, they're sorted and merged in one pass.
+static constexpr int MAX_BINARY_INSERTS = 16;
+
+static const RowBitmap& apply_filters(Model& model, Settings& settings, FilterCache& filter_cache);
+static void apply_filter(Model& model, int j, const ValueMap& allowed_values, RowBitmap& row_included);
+static void collect_rows(const RowBitmap& row_included, std::vector<int>& rows);
+static void lay_out_groups(Model& model, Settings& settings, const RowBitmap& row_included, ResultsCache& cache,
+                           Results& results);
+static void update_group_collapsed(Settings& settings, const Groups& groups);
+static Groups group_rows(Model& model, const std::vector<int>& grouped_columns, const RowBitmap& row_included,
+                         std::vector<uint32_t>& row_groups);
+static void aggregate_columns(Model& model, const std::vector<int>& aggregated_columns, ResultsCache& cache,
+                              bool regrouped);
+static void materialize_groups(Model& model, const std::vector<SortKey>& sort_keys, const RowBitmap& row_included,
+                               ResultsCache& cache, const std::vector<int>& group_list);
+static void sort_rows(Model& model, const std::vector<SortKey>& sort_keys, std::vector<int>& rows,
+                      SortKeyCache& sort_key_cache);
+static void merge_rows(Model& model, const std::vector<SortKey>& sort_keys, std::vector<int>& rows,
+                       std::vector<int>& new_rows);
+static const SortKeyCache::Column& column_sort_keys(Model& model, int j, SortKeyCache& sort_key_cache);
+
+// A row whose numbers move from the aggregates of one group to those of
+// another, either of which may be NO_GROUP
+struct RowMove {
+    int row;
+    uint32_t old_group;
+    uint32_t new_group;
+};
+
+static bool update_aggregates(Model& model, ResultsCache& cache, long since_ref, const ModelDelta& delta,
+                              const std::vector<uint32_t>& removed_groups, const std::vector<RowMove>& moves);
+static void remove_rows(RowBitmap& bitmap, const std::vector<int>& removed, int num_rows);
+template <typename T>
+static void remove_rows(std::vector<T>& values, const std::vector<int>& removed);
 
+Results apply_settings(Model& model, Settings& settings) {
+    ResultsCache cache;
     Results results;
-    
+    update_results(model, settings, cache, results);
+    return results;
+}
+
+void update_results(Model& model, Settings& settings, ResultsCache& cache, Results& results) {
+
     auto num_cols = model.columns();
-    auto num_rows = model.rows();
-    
+    auto ref = model.ref();
+    auto grouped = !settings.grouped_columns.empty();
+
     // Step 1. Apply filters
-    
-    std::vector<bool> row_included(num_rows);
-    std::fill(row_included.begin(), row_included.end(), true);
-    
-    for (int j = 0; j < num_cols; ++j) {
-        if (!settings.filters[j].enabled) {
-            continue;
-        }
-        
-        auto& allowed_values = settings.filters[j].allowed_values;
-        
-        for (int i = 0; i < num_rows; ++i) {
-            if (!row_included[i]) {
-                continue;
-            }
-        
-            auto cell = model.cell_text(i, j);
-            row_included[i] = (allowed_values.find(cell) != allowed_values.end());
+
+    auto& row_included = apply_filters(model, settings, cache.filter_cache);
+
+    // Step 2. Count the rows of each group
+
+    bool run = (!cache.valid ||
+                cache.ref != ref ||
+                cache.filtered_version != cache.filter_cache.version ||
+                cache.grouped_columns != settings.grouped_columns);
+    if (run) {
+        cache.ref = ref;
+        cache.filtered_version = cache.filter_cache.version;
+        cache.grouped_columns = settings.grouped_columns;
+        cache.valid = true;
+        cache.group_layout = GroupLayout();
+        cache.group_index.clear();
+
+        if (grouped) {
+            cache.groups = group_rows(model, settings.grouped_columns, row_included, cache.row_groups);
+            update_group_collapsed(settings, cache.groups);
+        } else {
+            cache.groups.assign(1, Group());
+            cache.row_groups.clear();
         }
     }
-    
-    for (int i = 0; i < num_rows; ++i) {
-        if (row_included[i]) {
-            results.row_indices.push_back(i);
+
+    // Step 2b. Total up the aggregated columns for each group. The rows
+    // of the groups stay as they are, but the headings need laying out.
+
+    bool relayout = false;
+    if (run || cache.aggregated_columns != settings.aggregated_columns) {
+        if (grouped) {
+            aggregate_columns(model, settings.aggregated_columns, cache, run);
         }
+        cache.aggregated_columns = settings.aggregated_columns;
+        relayout = true;
     }
-    
-    // Step 2. Apply sorting
-    
-    if (settings.sort_column != -1) {
-        auto j = settings.sort_column;
-    
-        std::function<bool(int,int)> compare;
-        if (settings.sort_ascending) {
-            compare = [&](int i1, int i2) {
-                return alphacmp_ascending(model.cell_text(i1, j), model.cell_text(i2, j));
-            };
-        } else {
-            compare = [&](int i1, int i2) {
-                return alphacmp_descending(model.cell_text(i1, j), model.cell_text(i2, j));
-            };
+
+    // Step 3. Forget the rows of each group when the sorting changed
+
+    run = (run || cache.sort_keys != settings.sort_keys);
+    if (run) {
+        cache.sort_keys = settings.sort_keys;
+        for (auto& group : cache.groups) {
+            group.materialized = false;
+            group.rows = std::vector<int>();
         }
-        std::sort(results.row_indices.begin(), results.row_indices.end(), compare);
     }
-    
-    // Step 3. Apply column reordering, enabling
-    
+
+    // Step 4. Lay out all results linearly, sorting groups as they're
+    // first shown expanded
+
+    run = (run || relayout || cache.group_collapsed != settings.group_collapsed);
+    if (run) {
+        lay_out_groups(model, settings, row_included, cache, results);
+    }
+
+    // Step 5. Apply column reordering, enabling
+
+    results.column_indices.clear();
     for (int j = 0; j < num_cols; ++j) {
         auto col = settings.column_ordering[j];
-        if (settings.column_enabled[col]) {
+        if (group_level(settings, col) == -1 && settings.column_enabled[col]) {
             results.column_indices.push_back(col);
         }
     }
-    
-    return results;
 }
 
-Results apply_settings_grouped(Model& model, Settings& settings) {
-    Results results;
-    
+bool update_results_from_delta(Model& model, Settings& settings, ResultsCache& cache, Results& results,
+                               long since_ref, const ModelDelta& delta) {
     auto num_cols = model.columns();
     auto num_rows = model.rows();
-    
-    // Step 1. Apply filters
-    
-    std::vector<bool> row_included(num_rows);
-    std::fill(row_included.begin(), row_included.end(), true);
-    
+    auto ref = model.ref();
+    auto grouped = !settings.grouped_columns.empty();
+    auto& filter_cache = cache.filter_cache;
+    auto& groups = cache.groups;
+
+    // The results have to be for since_ref and the current settings
+    if (!cache.valid || cache.ref != since_ref ||
+        filter_cache.ref != since_ref || cache.filtered_version != filter_cache.version ||
+        cache.grouped_columns != settings.grouped_columns ||
+        cache.aggregated_columns != settings.aggregated_columns ||
+        cache.sort_keys != settings.sort_keys ||
+        cache.group_collapsed != settings.group_collapsed) {
+        return false;
+    }
+
+    std::vector<int> enabled_columns;
     for (int j = 0; j < num_cols; ++j) {
-        if (!settings.filters[j].enabled) {
+        auto& filter = settings.filters[j];
+        if (!filter.enabled) {
             continue;
         }
-        
-        auto& allowed_values = settings.filters[j].allowed_values;
-        
-        for (int i = 0; i < num_rows; ++i) {
-            if (!row_included[i]) {
+        enabled_columns.push_back(j);
+        if (j >= filter_cache.columns.size() ||
+            filter_cache.columns[j].ref != since_ref ||
+            filter_cache.columns[j].allowed_values != filter.allowed_values) {
+            return false;
+        }
+    }
+    if (filter_cache.combined_columns != enabled_columns) {
+        return false;
+    }
+
+    // Step 1. Find the rows that may have moved: appended rows, and
+    // updated rows with a cell that's filtered, grouped or sorted by
+
+    std::vector<char> placing_column(num_cols, 0);
+    for (auto j : enabled_columns) {
+        placing_column[j] = 1;
+    }
+    for (auto j : settings.grouped_columns) {
+        placing_column[j] = 1;
+    }
+    for (auto& sort_key : settings.sort_keys) {
+        placing_column[sort_key.column] = 1;
+    }
+
+    auto aggregated = grouped && !settings.aggregated_columns.empty();
+    std::vector<char> aggregated_column(num_cols, 0);
+    for (auto j : settings.aggregated_columns) {
+        aggregated_column[j] = 1;
+    }
+
+    auto first_appended = num_rows - delta.appended_rows;
+    std::vector<int> changed_rows = delta.updated_rows;
+    std::vector<int> recounted_rows; // rows with an updated aggregated cell
+    for (auto& cell : delta.updated_cells) {
+        if (placing_column[cell.second]) {
+            changed_rows.push_back(cell.first);
+        }
+        if (aggregated && aggregated_column[cell.second]) {
+            recounted_rows.push_back(cell.first);
+        }
+    }
+    std::sort(changed_rows.begin(), changed_rows.end());
+    changed_rows.erase(std::unique(changed_rows.begin(), changed_rows.end()), changed_rows.end());
+    for (int i = first_appended; i < num_rows; ++i) {
+        changed_rows.push_back(i);
+    }
+    auto& removed = delta.removed_rows;
+    if (changed_rows.size() + removed.size() > settings.max_delta_churn * num_rows) {
+        return false;
+    }
+
+    // Step 2. Take the removed rows out of their group, and renumber the
+    // rows after them. Removal keeps the remaining rows in order, so the
+    // sorted rows of each group stay sorted.
+
+    std::vector<uint32_t> removed_groups;
+    if (!removed.empty()) {
+        auto old_rows = first_appended + (int)removed.size();
+        for (auto i : removed) {
+            auto group = (grouped ? cache.row_groups[i] :
+                          row_is_set(filter_cache.row_included, i) ? 0 : NO_GROUP);
+            removed_groups.push_back(group);
+            if (group == NO_GROUP) {
+                continue;
+            }
+            for (int k = group; k != -1; k = groups[k].parent) {
+                --groups[k].count;
+            }
+        }
+
+        remove_rows(filter_cache.row_included, removed, old_rows);
+        for (auto j : enabled_columns) {
+            remove_rows(filter_cache.columns[j].row_included, removed, old_rows);
+        }
+        if (grouped) {
+            remove_rows(cache.row_groups, removed);
+        }
+        for (auto& group : groups) {
+            if (!group.materialized) {
                 continue;
             }
-        
-            auto cell = model.cell_text(i, j);
-            row_included[i] = (allowed_values.find(cell) != allowed_values.end());
+            int output = 0;
+            for (auto i : group.rows) {
+                auto row = map_row_through_delta(delta, i);
+                if (row != -1) {
+                    group.rows[output++] = row;
+                }
+            }
+            group.rows.resize(output);
         }
     }
 
-    // Step 2. Sort into groups
+    // Step 3. Evaluate the filters for the changed rows
+
+    auto num_words = bitmap_words(num_rows);
+    auto& row_included = filter_cache.row_included;
+    std::vector<char> was_included(changed_rows.size());
+    for (int k = 0; k < changed_rows.size(); ++k) {
+        was_included[k] = (changed_rows[k] < first_appended && row_is_set(row_included, changed_rows[k]));
+    }
+    row_included.resize(num_words, 0);
+    for (auto j : enabled_columns) {
+        filter_cache.columns[j].row_included.resize(num_words, 0);
+    }
+    for (auto i : changed_rows) {
+        bool included = true;
+        for (auto j : enabled_columns) {
+            auto& column = filter_cache.columns[j];
+            if (column.allowed_values.find(model.cell_view(i, j)) != column.allowed_values.end()) {
+                set_row(column.row_included, i);
+            } else {
+                clear_row(column.row_included, i);
+                included = false;
+            }
+        }
+        if (included) {
+            set_row(row_included, i);
+        } else {
+            clear_row(row_included, i);
+        }
+    }
+    for (auto j : enabled_columns) {
+        filter_cache.columns[j].ref = ref;
+    }
+    filter_cache.ref = ref;
 
-    auto j = settings.grouped_column;
-    std::map<std::string, std::vector<int>, alphacmp_operator> groups;
-    for (int i = 0; i < num_rows; ++i) {
-        if (!row_included[i]) {
+    // Step 4. Move the changed rows to their new group, keeping the
+    // counts of the groups and their parents up to date
+
+    if (grouped && cache.group_index.empty()) {
+        for (uint32_t k = 0; k < groups.size(); ++k) {
+            if (groups[k].level == settings.grouped_columns.size() - 1) {
+                cache.group_index.insert(std::make_pair(groups[k].key, k));
+            }
+        }
+    }
+    if (grouped) {
+        cache.row_groups.resize(num_rows, NO_GROUP);
+    }
+
+    // Rows taken out of and put into each group
+    std::unordered_map<uint32_t, std::vector<int>> leaving, joining;
+    std::vector<RowMove> moves;
+    std::string key;
+    for (int k = 0; k < changed_rows.size(); ++k) {
+        auto i = changed_rows[k];
+        auto old_group = (grouped ? cache.row_groups[i] : was_included[k] ? 0 : NO_GROUP);
+        auto new_group = NO_GROUP;
+        if (row_is_set(row_included, i)) {
+            new_group = 0;
+        }
+        if (grouped && new_group != NO_GROUP) {
+            key.clear();
+            for (auto j : settings.grouped_columns) {
+                append_key_cell(key, model.cell_view(i, j));
+            }
+            auto lookup = cache.group_index.find(key);
+            if (lookup == cache.group_index.end()) {
+                cache.valid = false; // the row needs a new group
+                return false;
+            }
+            new_group = lookup->second;
+        }
+        if (grouped) {
+            cache.row_groups[i] = new_group;
+        }
+        if (aggregated) {
+            moves.push_back(RowMove{i, old_group, new_group});
+        }
+
+        if (old_group != NO_GROUP) {
+            leaving[old_group].push_back(i);
+            for (int group = old_group; group != -1; group = groups[group].parent) {
+                --groups[group].count;
+            }
+        }
+        if (new_group != NO_GROUP) {
+            joining[new_group].push_back(i);
+            for (int group = new_group; group != -1; group = groups[group].parent) {
+                ++groups[group].count;
+            }
+        }
+    }
+    for (auto& group : groups) {
+        if (grouped && group.count == 0) {
+            cache.valid = false; // the group has to go
+            return false;
+        }
+    }
+
+    // Step 5. Take the rows out of the groups that are materialized, and
+    // merge them back in at their new position
+
+    RowBitmap is_leaving(num_words, 0);
+    for (auto& pair : leaving) {
+        if (!groups[pair.first].materialized) {
             continue;
         }
+        for (auto i : pair.second) {
+            set_row(is_leaving, i);
+        }
+        auto& rows = groups[pair.first].rows;
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [&](int i) {
+            return row_is_set(is_leaving, i);
+        }), rows.end());
+        for (auto i : pair.second) {
+            clear_row(is_leaving, i);
+        }
+    }
+    for (auto& pair : joining) {
+        auto& group = groups[pair.first];
+        if (group.materialized) {
+            merge_rows(model, settings.sort_keys, group.rows, pair.second);
+        }
+    }
 
-        auto lookup = groups.find(model.cell_text(i, j));
-        if (lookup == groups.end()) {
-            groups.insert(std::make_pair(model.cell_text(i, j), std::vector<int> { i }));
-        } else {
-            lookup->second.push_back(i);
-        }
-    }
-    
-    // Step 3. Apply sorting to each group
-    
-    if (settings.sort_column != -1) {
-        auto j = settings.sort_column;
-    
-        std::function<bool(int,int)> compare;
-        if (settings.sort_ascending) {
-            compare = [&](int i1, int i2) {
-                return alphacmp_ascending(model.cell_text(i1, j), model.cell_text(i2, j));
-            };
-        } else {
-            compare = [&](int i1, int i2) {
-                return alphacmp_descending(model.cell_text(i1, j), model.cell_text(i2, j));
-            };
+    // Step 6. Move the numbers of the changed rows between the aggregates
+    // of their groups. Rows whose group didn't change but had a number
+    // updated move within their group.
+
+    std::sort(recounted_rows.begin(), recounted_rows.end());
+    recounted_rows.erase(std::unique(recounted_rows.begin(), recounted_rows.end()), recounted_rows.end());
+    for (auto i : recounted_rows) {
+        if (!std::binary_search(changed_rows.begin(), changed_rows.end(), i)) {
+            auto group = cache.row_groups[i];
+            moves.push_back(RowMove{i, group, group});
+        }
+    }
+
+    // Rows laid out by group are out of date
+    cache.group_layout = GroupLayout();
+    if (aggregated && !update_aggregates(model, cache, since_ref, delta, removed_groups, moves)) {
+        aggregate_columns(model, settings.aggregated_columns, cache, true);
+    }
+
+    cache.ref = ref;
+    lay_out_groups(model, settings, row_included, cache, results);
+    return true;
+}
+
+// Lays out all results linearly, listing and sorting the rows of the
+// groups that are shown expanded. A collapsed group hides its
+// subgroups too.
+void lay_out_groups(Model& model, Settings& settings, const RowBitmap& row_included, ResultsCache& cache,
+                    Results& results) {
+    auto grouped = !settings.grouped_columns.empty();
+    cache.group_collapsed = settings.group_collapsed;
+
+    auto& groups = cache.groups;
+    auto innermost_level = (int)settings.grouped_columns.size() - 1;
+    std::vector<char> is_shown(groups.size(), 0);
+    std::vector<int> expanded;
+    int hidden_level = INT_MAX; // groups deeper than this are hidden
+    for (int k = 0; k < groups.size(); ++k) {
+        auto& group = groups[k];
+        if (group.level > hidden_level) {
+            continue;
         }
+        is_shown[k] = 1;
+        hidden_level = INT_MAX;
 
-        for (auto& pair : groups) {
-            std::sort(pair.second.begin(), pair.second.end(), compare);
+        auto lookup = settings.group_collapsed.find(group.key);
+        if (grouped && lookup != settings.group_collapsed.end() && lookup->second) {
+            hidden_level = group.level;
+        } else if (group.level == innermost_level || !grouped) {
+            expanded.push_back(k);
         }
     }
+    materialize_groups(model, settings.sort_keys, row_included, cache, expanded);
 
-    // Step 4. Lay out all results linearly
+    results.row_indices.clear();
+    results.group_headings.clear();
+
+    if (!grouped) {
+        results.row_indices = groups.front().rows;
+    }
+
+    auto next_expanded = expanded.begin();
+    for (int k = 0; grouped && k < groups.size(); ++k) {
+        if (!is_shown[k]) {
+            continue;
+        }
+        auto& group = groups[k];
 
-    for (auto& pair : groups) {
         GroupHeading group_heading;
         group_heading.position = results.row_indices.size();
-        group_heading.value = pair.first;
-        group_heading.count = pair.second.size();
+        group_heading.level = group.level;
+        group_heading.value = group.value;
+        group_heading.key = group.key;
+        group_heading.count = group.count;
+        group_heading.aggregates = group.aggregates;
         results.group_headings.push_back(std::move(group_heading));
 
         results.row_indices.push_back(-1);
 
-        if (settings.group_collapsed[pair.first]) {
-            continue;
+        if (next_expanded != expanded.end() && *next_expanded == k) {
+            results.row_indices.insert(results.row_indices.end(), group.rows.begin(), group.rows.end());
+            ++next_expanded;
         }
+    }
+}
 
-        for (auto i : pair.second) {
-            results.row_indices.push_back(i);
+// Carries the collapsed state of each group over to the new groups.
+// Collapsed groups that aren't shown (say, because of a filter) stay
+// collapsed for when they come back.
+void update_group_collapsed(Settings& settings, const Groups& groups) {
+    auto previous_group_collapsed = std::move(settings.group_collapsed);
+    settings.group_collapsed.clear();
+
+    for (auto& group : groups) {
+        auto lookup = previous_group_collapsed.find(group.key);
+        auto collapsed = (lookup != previous_group_collapsed.end() && lookup->second);
+        settings.group_collapsed.insert(std::make_pair(group.key, collapsed));
+    }
+    for (auto& pair : previous_group_collapsed) {
+        if (pair.second) {
+            settings.group_collapsed.insert(pair);
         }
     }
-    
-    // Step 5. Apply column reordering, enabling
-    
+}
+
+// Lists the rows of the given groups that aren't materialized yet, in
+// a single pass over the group of each row, then sorts them
+void materialize_groups(Model& model, const std::vector<SortKey>& sort_keys, const RowBitmap& row_included,
+                        ResultsCache& cache, const std::vector<int>& group_list) {
+    auto& groups = cache.groups;
+    std::vector<int> pending;
+    for (auto k : group_list) {
+        if (!groups[k].materialized) {
+            pending.push_back(k);
+        }
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    if (cache.grouped_columns.empty()) {
+        // The one group of all rows that pass the filters
+        collect_rows(row_included, groups[0].rows);
+        groups[0].count = groups[0].rows.size();
+    } else if (!cache.group_layout.begin.empty()) {
+        // The rows are already laid out by group for the aggregates
+        auto& layout = cache.group_layout;
+        for (auto k : pending) {
+            groups[k].rows.assign(layout.rows.begin() + layout.begin[k], layout.rows.begin() + layout.begin[k + 1]);
+        }
+    } else {
+        std::vector<char> wanted(groups.size(), 0);
+        for (auto k : pending) {
+            wanted[k] = 1;
+            groups[k].rows.reserve(groups[k].count);
+        }
+        auto num_rows = (int)cache.row_groups.size();
+        for (int i = 0; i < num_rows; ++i) {
+            auto k = cache.row_groups[i];
+            if (k != NO_GROUP && wanted[k]) {
+                groups[k].rows.push_back(i);
+            }
+        }
+    }
+
+    for (auto k : pending) {
+        if (!sort_keys.empty()) {
+            sort_rows(model, sort_keys, groups[k].rows, cache.sort_key_cache);
+        }
+        groups[k].materialized = true;
+    }
+}
+
+const RowBitmap& apply_filters(Model& model, Settings& settings, FilterCache& filter_cache) {
+    auto num_cols = model.columns();
+    auto num_rows = model.rows();
+    auto ref = model.ref();
+
+    // Bring the bitmap of each enabled filter up to date, only
+    // evaluating the filters that changed since they were cached
+    filter_cache.columns.resize(num_cols);
+    std::vector<int> enabled_columns;
+    bool recomputed = false;
     for (int j = 0; j < num_cols; ++j) {
-        auto col = settings.column_ordering[j];
-        if (col != settings.grouped_column && settings.column_enabled[col]) {
-            results.column_indices.push_back(col);
+        auto& filter = settings.filters[j];
+        if (!filter.enabled) {
+            continue;
         }
+        enabled_columns.push_back(j);
+
+        auto& column = filter_cache.columns[j];
+        if (column.ref == ref && column.allowed_values == filter.allowed_values) {
+            continue;
+        }
+        column.ref = ref;
+        column.allowed_values = filter.allowed_values;
+        apply_filter(model, j, filter.allowed_values, column.row_included);
+        recomputed = true;
     }
-    
-    return results;
+
+    // Then AND them together, unless the same bitmaps were combined last time
+    if (!recomputed && filter_cache.ref == ref &&
+        filter_cache.combined_columns == enabled_columns) {
+        return filter_cache.row_included;
+    }
+
+    auto& row_included = filter_cache.row_included;
+    ++filter_cache.version;
+    row_included.assign(bitmap_words(num_rows), ~(uint64_t)0);
+    if (num_rows % 64 != 0) {
+        row_included.back() = ((uint64_t)1 << (num_rows % 64)) - 1;
+    }
+
+    auto num_words = (int)row_included.size();
+    auto words_per_task = ROWS_PER_TASK / 64;
+    auto num_tasks = (num_words + words_per_task - 1) / words_per_task;
+    WorkerPool::shared().parallel_for(num_tasks, [&](int k) {
+        auto begin = k * words_per_task;
+        auto end = std::min(begin + words_per_task, num_words);
+        for (auto j : enabled_columns) {
+            auto& column_included = filter_cache.columns[j].row_included;
+            for (int w = begin; w < end; ++w) {
+                row_included[w] &= column_included[w];
+            }
+        }
+    });
+
+    filter_cache.ref = ref;
+    filter_cache.combined_columns = std::move(enabled_columns);
+
+    return row_included;
+}
+
+void apply_filter(Model& model, int j, const ValueMap& allowed_values, RowBitmap& row_included) {
+    auto num_rows = model.rows();
+    row_included.assign(bitmap_words(num_rows), 0);
+
+    // For a dictionary encoded column, look up each distinct value
+    // in the filter once, then test the cells by their id
+    auto dictionary = model.column_has_dictionary(j);
+    std::vector<char> id_allowed;
+    if (dictionary) {
+        auto dictionary_size = model.dictionary_size(j);
+        id_allowed.resize(dictionary_size);
+        for (int id = 0; id < dictionary_size; ++id) {
+            auto& value = model.dictionary_text(j, id);
+            id_allowed[id] = (allowed_values.find(value) != allowed_values.end());
+        }
+    }
+
+    // Each task fills in whole words of the bitmap, so tasks never
+    // write to the same word
+    auto filter_rows = [&](int k) {
+        auto begin = k * ROWS_PER_TASK;
+        auto end = std::min(begin + ROWS_PER_TASK, num_rows);
+        if (dictionary) {
+            for_each_cell_id(model, j, begin, end, [&](int i, uint32_t id) {
+                if (id_allowed[id]) {
+                    set_row(row_included, i);
+                }
+            });
+        } else {
+            for_each_cell(model, j, begin, end, [&](int i, std::string_view cell) {
+                if (allowed_values.find(cell) != allowed_values.end()) {
+                    set_row(row_included, i);
+                }
+            });
+        }
+    };
+
+    auto num_tasks = (num_rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    if (model.concurrent_cells(j)) {
+        WorkerPool::shared().parallel_for(num_tasks, filter_rows);
+    } else {
+        for (int k = 0; k < num_tasks; ++k) {
+            filter_rows(k);
+        }
+    }
+}
+
+// Lists the rows in the bitmap in order. Each task counts the rows in
+// its part of the bitmap, and a prefix sum over the counts tells each
+// task where in `rows` to write its part.
+void collect_rows(const RowBitmap& row_included, std::vector<int>& rows) {
+    auto num_words = (int)row_included.size();
+    auto words_per_task = ROWS_PER_TASK / 64;
+    auto num_tasks = (num_words + words_per_task - 1) / words_per_task;
+    auto& pool = WorkerPool::shared();
+
+    std::vector<int> offsets(num_tasks + 1, 0);
+    pool.parallel_for(num_tasks, [&](int k) {
+        auto begin = k * words_per_task;
+        auto end = std::min(begin + words_per_task, num_words);
+        int count = 0;
+        for (int w = begin; w < end; ++w) {
+            count += count_bits(row_included[w]);
+        }
+        offsets[k + 1] = count;
+    });
+    for (int k = 0; k < num_tasks; ++k) {
+        offsets[k + 1] += offsets[k];
+    }
+
+    rows.resize(offsets[num_tasks]);
+    pool.parallel_for(num_tasks, [&](int k) {
+        auto begin = k * words_per_task;
+        auto end = std::min(begin + words_per_task, num_words);
+        auto out = rows.data() + offsets[k];
+        for (int w = begin; w < end; ++w) {
+            for (auto word = row_included[w]; word != 0; word &= word - 1) {
+                *out++ = w * 64 + lowest_bit(word);
+            }
+        }
+    });
+}
+
+int group_level(Settings& settings, int column) {
+    for (int k = 0; k < settings.grouped_columns.size(); ++k) {
+        if (settings.grouped_columns[k] == column) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+int sort_key_index(Settings& settings, int column) {
+    for (int k = 0; k < settings.sort_keys.size(); ++k) {
+        if (settings.sort_keys[k].column == column) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+void toggle_sort_key(Settings& settings, int column, bool ascending) {
+    auto k = sort_key_index(settings, column);
+    if (k == -1) {
+        settings.sort_keys.push_back({ column, ascending });
+    } else if (settings.sort_keys[k].ascending != ascending) {
+        settings.sort_keys[k].ascending = ascending;
+    } else {
+        settings.sort_keys.erase(settings.sort_keys.begin() + k);
+    }
+}
+
+// Numbers the distinct texts of cells, using an open addressing hash
+// table from the text to its number. Lookups for a run of equal cells
+// skip the hashing, as column values tend to come in runs.
+class GroupIndex {
+    public:
+        GroupIndex() : slots(1024, EMPTY), last(EMPTY) {}
+
+        uint32_t find(std::string_view value) {
+            if (last != EMPTY && values[last] == value) {
+                return last;
+            }
+
+            auto hash = std::hash<std::string_view>()(value);
+            auto mask = slots.size() - 1;
+            for (auto slot = hash & mask; ; slot = (slot + 1) & mask) {
+                auto group = slots[slot];
+                if (group == EMPTY) {
+                    group = (uint32_t)values.size();
+                    slots[slot] = group;
+                    values.emplace_back(value);
+                    hashes.push_back(hash);
+                    if (2 * values.size() > slots.size()) {
+                        grow();
+                    }
+                    return last = group;
+                }
+                if (hashes[group] == hash && values[group] == value) {
+                    return last = group;
+                }
+            }
+        }
+
+        std::vector<std::string> values;
+
+    private:
+        static constexpr uint32_t EMPTY = ~(uint32_t)0;
+
+        void grow() {
+            slots.assign(2 * slots.size(), EMPTY);
+            auto mask = slots.size() - 1;
+            for (uint32_t group = 0; group < values.size(); ++group) {
+                auto slot = hashes[group] & mask;
+                while (slots[slot] != EMPTY) {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = group;
+            }
+        }
+
+        std::vector<uint32_t> slots;
+        std::vector<size_t> hashes;
+        uint32_t last;
+};
+
+// Orders the distinct values with a single alphacmp sort, and fills in
+// to_rank with the position of each value in the sorted list. Values
+// that alphacmp considers equal (e.g. "1" and "01") share a position,
+// as they would as keys of an alphacmp-ordered map.
+static std::vector<std::string> sort_values(std::vector<std::string>& values, std::vector<uint32_t>& to_rank) {
+    std::vector<uint32_t> order(values.size());
+    for (uint32_t k = 0; k < order.size(); ++k) {
+        order[k] = k;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t k1, uint32_t k2) {
+        return alphacmp_ascending(values[k1], values[k2]);
+    });
+
+    std::vector<std::string> output;
+    to_rank.resize(values.size());
+    for (auto k : order) {
+        if (output.empty() || alphacmp(output.back(), values[k]) != 0) {
+            output.push_back(std::move(values[k]));
+        }
+        to_rank[k] = output.size() - 1;
+    }
+    return output;
+}
+
+// Ranks the cell of each row that passes the filters among the distinct
+// values of the column, returning the values in alphacmp order. Rows
+// that don't pass the filters get NO_GROUP.
+static std::vector<std::string> rank_cells(Model& model, int j, const RowBitmap& row_included,
+                                           std::vector<uint32_t>& ranks) {
+    auto num_rows = model.rows();
+    auto num_tasks = (num_rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    auto& pool = WorkerPool::shared();
+    ranks.resize(num_rows);
+
+    // For a dictionary encoded column, start from the ids
+    if (model.column_has_dictionary(j)) {
+        std::vector<char> id_used(model.dictionary_size(j), 0);
+        for_each_cell_id(model, j, [&](int i, uint32_t id) {
+            if (row_is_set(row_included, i)) {
+                ranks[i] = id;
+                id_used[id] = 1;
+            } else {
+                ranks[i] = NO_GROUP;
+            }
+        });
+
+        std::vector<uint32_t> ids;
+        std::vector<std::string> values;
+        for (uint32_t id = 0; id < id_used.size(); ++id) {
+            if (id_used[id]) {
+                ids.push_back(id);
+                values.push_back(model.dictionary_text(j, id));
+            }
+        }
+
+        std::vector<uint32_t> to_rank;
+        auto sorted_values = sort_values(values, to_rank);
+        std::vector<uint32_t> id_to_rank(id_used.size(), NO_GROUP);
+        for (int k = 0; k < ids.size(); ++k) {
+            id_to_rank[ids[k]] = to_rank[k];
+        }
+        pool.parallel_for(num_tasks, [&](int k) {
+            auto end = std::min((k + 1) * ROWS_PER_TASK, num_rows);
+            for (int i = k * ROWS_PER_TASK; i < end; ++i) {
+                if (ranks[i] != NO_GROUP) {
+                    ranks[i] = id_to_rank[ranks[i]];
+                }
+            }
+        });
+        return sorted_values;
+    }
+
+    // Otherwise, number the distinct cells with a hash table per task,
+    // then combine the tasks' numbering
+    std::vector<GroupIndex> task_index(num_tasks);
+    auto number_rows = [&](int k) {
+        auto begin = k * ROWS_PER_TASK;
+        auto end = std::min(begin + ROWS_PER_TASK, num_rows);
+        auto& index = task_index[k];
+        for_each_cell(model, j, begin, end, [&](int i, std::string_view cell) {
+            ranks[i] = (row_is_set(row_included, i) ? index.find(cell) : NO_GROUP);
+        });
+    };
+    if (model.concurrent_cells(j)) {
+        pool.parallel_for(num_tasks, number_rows);
+    } else {
+        for (int k = 0; k < num_tasks; ++k) {
+            number_rows(k);
+        }
+    }
+
+    GroupIndex index;
+    std::vector<std::vector<uint32_t>> task_to_value(num_tasks);
+    for (int k = 0; k < num_tasks; ++k) {
+        for (auto& value : task_index[k].values) {
+            task_to_value[k].push_back(index.find(value));
+        }
+        task_index[k] = GroupIndex();
+    }
+
+    std::vector<uint32_t> to_rank;
+    auto sorted_values = sort_values(index.values, to_rank);
+    pool.parallel_for(num_tasks, [&](int k) {
+        auto& to_value = task_to_value[k];
+        auto end = std::min((k + 1) * ROWS_PER_TASK, num_rows);
+        for (int i = k * ROWS_PER_TASK; i < end; ++i) {
+            if (ranks[i] != NO_GROUP) {
+                ranks[i] = to_rank[to_value[ranks[i]]];
+            }
+        }
+    });
+    return sorted_values;
+}
+
+// Groups the rows by the values of several columns, nesting the groups
+// of each column in those of the columns before it. Filling in the
+// group of each row counts the rows of the innermost groups, and the
+// outer groups then add up the counts of their subgroups.
+Groups group_rows(Model& model, const std::vector<int>& grouped_columns, const RowBitmap& row_included,
+                  std::vector<uint32_t>& row_groups) {
+    auto num_rows = model.rows();
+    auto num_levels = (int)grouped_columns.size();
+
+    // Step 1. Find the node of each row at every level. A node is a
+    // distinct combination of values of the columns up to that level.
+    // Nodes are numbered by their parent node and then their value, so
+    // the children of each node are numbered consecutively, in order.
+    struct Level {
+        std::vector<std::string> values;
+        std::vector<uint32_t> node_parents;
+        std::vector<uint32_t> node_values;
+        std::vector<uint32_t> node_groups;
+    };
+    std::vector<Level> levels(num_levels);
+    std::vector<uint32_t> nodes;
+    std::vector<uint32_t> ranks;
+
+    levels[0].values = rank_cells(model, grouped_columns[0], row_included, nodes);
+    for (uint32_t value = 0; value < levels[0].values.size(); ++value) {
+        levels[0].node_parents.push_back(NO_GROUP);
+        levels[0].node_values.push_back(value);
+    }
+
+    for (int l = 1; l < num_levels; ++l) {
+        auto& level = levels[l];
+        level.values = rank_cells(model, grouped_columns[l], row_included, ranks);
+
+        // When there aren't many more combinations of parent node and
+        // value than rows, number them through an array indexed by the
+        // combination, which also keeps them in order. Otherwise, use
+        // a hash table and sort the combinations found.
+        auto num_parents = (uint64_t)levels[l - 1].node_values.size();
+        auto num_values = (uint64_t)level.values.size();
+        if (num_parents * num_values <= 2 * (uint64_t)num_rows + 1024) {
+            std::vector<uint32_t> pair_nodes(num_parents * num_values, NO_GROUP);
+            for (int i = 0; i < num_rows; ++i) {
+                if (nodes[i] != NO_GROUP) {
+                    pair_nodes[nodes[i] * num_values + ranks[i]] = 0;
+                }
+            }
+            uint32_t next_node = 0;
+            for (uint64_t pair = 0; pair < pair_nodes.size(); ++pair) {
+                if (pair_nodes[pair] != NO_GROUP) {
+                    pair_nodes[pair] = next_node++;
+                    level.node_parents.push_back((uint32_t)(pair / num_values));
+                    level.node_values.push_back((uint32_t)(pair % num_values));
+                }
+            }
+            for (int i = 0; i < num_rows; ++i) {
+                if (nodes[i] != NO_GROUP) {
+                    nodes[i] = pair_nodes[nodes[i] * num_values + ranks[i]];
+                }
+            }
+            continue;
+        }
+
+        std::unordered_map<uint64_t, uint32_t> pair_nodes;
+        std::vector<uint64_t> pairs;
+        uint64_t last_pair = ~(uint64_t)0;
+        uint32_t last_node = NO_GROUP;
+        for (int i = 0; i < num_rows; ++i) {
+            if (nodes[i] == NO_GROUP) {
+                continue;
+            }
+            auto pair = ((uint64_t)nodes[i] << 32) | ranks[i];
+            if (pair != last_pair) {
+                auto insert = pair_nodes.insert(std::make_pair(pair, (uint32_t)pairs.size()));
+                if (insert.second) {
+                    pairs.push_back(pair);
+                }
+                last_pair = pair;
+                last_node = insert.first->second;
+            }
+            nodes[i] = last_node;
+        }
+
+        std::vector<uint32_t> order(pairs.size());
+        for (uint32_t k = 0; k < order.size(); ++k) {
+            order[k] = k;
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t k1, uint32_t k2) {
+            return pairs[k1] < pairs[k2];
+        });
+        std::vector<uint32_t> renumbered(pairs.size());
+        for (uint32_t k = 0; k < order.size(); ++k) {
+            renumbered[order[k]] = k;
+            level.node_parents.push_back((uint32_t)(pairs[order[k]] >> 32));
+            level.node_values.push_back((uint32_t)pairs[order[k]]);
+        }
+        for (auto& node : nodes) {
+            if (node != NO_GROUP) {
+                node = renumbered[node];
+            }
+        }
+    }
+    ranks = std::vector<uint32_t>();
+
+    // Step 2. List the groups in the order they're shown, each followed
+    // by its subgroups
+    std::vector<std::vector<uint32_t>> child_begin(num_levels);
+    for (int l = 0; l + 1 < num_levels; ++l) {
+        auto& children = levels[l + 1].node_parents;
+        child_begin[l].resize(levels[l].node_values.size() + 1);
+        uint32_t child = 0;
+        for (uint32_t node = 0; node <= levels[l].node_values.size(); ++node) {
+            while (child < children.size() && children[child] < node) {
+                ++child;
+            }
+            child_begin[l][node] = child;
+        }
+    }
+
+    Groups groups;
+    std::vector<std::pair<int, uint32_t>> stack; // (level, node) still to list
+    for (auto node = (uint32_t)levels[0].node_values.size(); node > 0; --node) {
+        stack.push_back(std::make_pair(0, node - 1));
+    }
+    for (auto& level : levels) {
+        level.node_groups.resize(level.node_values.size());
+    }
+    while (!stack.empty()) {
+        auto l = stack.back().first;
+        auto node = stack.back().second;
+        stack.pop_back();
+
+        auto& level = levels[l];
+        auto parent = (l == 0 ? -1 : (int)levels[l - 1].node_groups[level.node_parents[node]]);
+        level.node_groups[node] = groups.size();
+
+        groups.emplace_back();
+        auto& group = groups.back();
+        group.level = l;
+        group.parent = parent;
+        group.value = level.values[level.node_values[node]];
+        group.key = (parent == -1 ? std::string() : groups[parent].key);
+        append_key_cell(group.key, group.value);
+
+        if (l + 1 < num_levels) {
+            for (auto child = child_begin[l][node + 1]; child > child_begin[l][node]; --child) {
+                stack.push_back(std::make_pair(l + 1, child - 1));
+            }
+        }
+    }
+
+    // Step 3. Place each row in its innermost group, counting the rows
+    auto& leaf_groups = levels[num_levels - 1].node_groups;
+    row_groups = std::move(nodes);
+    for (auto& k : row_groups) {
+        if (k != NO_GROUP) {
+            k = leaf_groups[k];
+            ++groups[k].count;
+        }
+    }
+
+    // Step 4. Add up the subgroups into their parents. Subgroups are
+    // listed after their parents, so go through the groups backwards.
+    for (auto k = (int)groups.size() - 1; k >= 0; --k) {
+        if (groups[k].parent != -1) {
+            groups[groups[k].parent].count += groups[k].count;
+        }
+    }
+
+    return groups;
+}
+
+// Fills in the aggregates of every group for the aggregated columns.
+// Columns that were aggregated before keep their totals, unless the
+// groups were just recomputed. The innermost groups are totalled up
+// over their rows, and the outer groups add up their subgroups.
+void aggregate_columns(Model& model, const std::vector<int>& aggregated_columns, ResultsCache& cache,
+                       bool regrouped) {
+    auto& groups = cache.groups;
+    auto num_aggregates = aggregated_columns.size();
+
+    std::vector<std::vector<Aggregate>> column_aggregates(num_aggregates);
+    std::vector<char> done(num_aggregates, 0);
+    for (size_t a = 0; a < num_aggregates && !regrouped; ++a) {
+        auto it = std::find(cache.aggregated_columns.begin(), cache.aggregated_columns.end(), aggregated_columns[a]);
+        if (it == cache.aggregated_columns.end()) {
+            continue;
+        }
+        auto previous = it - cache.aggregated_columns.begin();
+        column_aggregates[a].resize(groups.size());
+        for (size_t k = 0; k < groups.size(); ++k) {
+            column_aggregates[a][k] = groups[k].aggregates[previous];
+        }
+        done[a] = 1;
+    }
+
+    for (size_t a = 0; a < num_aggregates; ++a) {
+        if (done[a]) {
+            continue;
+        }
+        if (cache.group_layout.begin.empty()) {
+            layout_groups(cache.row_groups, groups.size(), cache.group_layout);
+        }
+        auto& values = column_numbers(model, aggregated_columns[a], cache.number_cache);
+        aggregate_groups(values, cache.group_layout, column_aggregates[a]);
+        for (auto k = (int)groups.size() - 1; k >= 0; --k) {
+            if (groups[k].parent != -1) {
+                merge_aggregate(column_aggregates[a][groups[k].parent], column_aggregates[a][k]);
+            }
+        }
+    }
+
+    for (size_t k = 0; k < groups.size(); ++k) {
+        auto& aggregates = groups[k].aggregates;
+        aggregates.resize(num_aggregates);
+        for (size_t a = 0; a < num_aggregates; ++a) {
+            aggregates[a] = column_aggregates[a][k];
+        }
+    }
+}
+
+// Brings the aggregates of the groups, and the numbers of the aggregated
+// columns in number_cache, up to date with a delta. The numbers of the
+// removed rows and moved rows are taken out of their old group, and the
+// new numbers of the moved rows added to their new group. The min or
+// max of a group is only found again when a number equal to it was
+// taken out. Returns false when the numbers weren't cached at since_ref.
+bool update_aggregates(Model& model, ResultsCache& cache, long since_ref, const ModelDelta& delta,
+                       const std::vector<uint32_t>& removed_groups, const std::vector<RowMove>& moves) {
+    auto& groups = cache.groups;
+    auto& columns = cache.number_cache.columns;
+    auto& aggregated_columns = cache.aggregated_columns;
+    auto& removed = delta.removed_rows;
+    auto num_aggregates = aggregated_columns.size();
+    auto num_rows = model.rows();
+
+    for (auto j : aggregated_columns) {
+        if (j >= columns.size() || columns[j].ref != since_ref) {
+            return false;
+        }
+    }
+
+    // Aggregates that may have lost their min or max, by group
+    std::vector<char> stale(groups.size() * num_aggregates, 0);
+    bool any_stale = false;
+
+    for (size_t a = 0; a < num_aggregates; ++a) {
+        auto j = aggregated_columns[a];
+        auto& values = columns[j].values;
+
+        auto take_out = [&](uint32_t group, double value) {
+            if (group == NO_GROUP || value != value) {
+                return;
+            }
+            for (int k = group; k != -1; k = groups[k].parent) {
+                auto& aggregate = groups[k].aggregates[a];
+                --aggregate.count;
+                aggregate.sum = (aggregate.count == 0 ? 0 : aggregate.sum - value);
+                if (value <= aggregate.min || value >= aggregate.max) {
+                    stale[k * num_aggregates + a] = 1;
+                    any_stale = true;
+                }
+            }
+        };
+        auto put_in = [&](uint32_t group, double value) {
+            if (group == NO_GROUP || value != value) {
+                return;
+            }
+            for (int k = group; k != -1; k = groups[k].parent) {
+                auto& aggregate = groups[k].aggregates[a];
+                ++aggregate.count;
+                aggregate.sum += value;
+                aggregate.min = std::min(aggregate.min, value);
+                aggregate.max = std::max(aggregate.max, value);
+            }
+        };
+
+        for (size_t r = 0; r < removed.size(); ++r) {
+            take_out(removed_groups[r], values[removed[r]]);
+        }
+        if (!removed.empty()) {
+            remove_rows(values, removed);
+        }
+        values.resize(num_rows, NAN);
+        for (auto& move : moves) {
+            take_out(move.old_group, values[move.row]);
+            values[move.row] = cell_number(model, move.row, j);
+            put_in(move.new_group, values[move.row]);
+        }
+        columns[j].ref = model.ref();
+    }
+
+    if (!any_stale) {
+        return true;
+    }
+
+    // Find the min and max of the stale aggregates again: for innermost
+    // groups over their rows (with one pass over all rows for those that
+    // aren't materialized), then for outer groups over their subgroups
+    for (size_t k = 0; k < groups.size(); ++k) {
+        for (size_t a = 0; a < num_aggregates; ++a) {
+            if (stale[k * num_aggregates + a]) {
+                groups[k].aggregates[a].min = INFINITY;
+                groups[k].aggregates[a].max = -INFINITY;
+            }
+        }
+    }
+
+    auto add_extremes = [&](uint32_t k, int i) {
+        for (size_t a = 0; a < num_aggregates; ++a) {
+            if (!stale[k * num_aggregates + a]) {
+                continue;
+            }
+            auto value = columns[aggregated_columns[a]].values[i];
+            if (value == value) {
+                auto& aggregate = groups[k].aggregates[a];
+                aggregate.min = std::min(aggregate.min, value);
+                aggregate.max = std::max(aggregate.max, value);
+            }
+        }
+    };
+    auto innermost_level = (int)cache.grouped_columns.size() - 1;
+    bool scan = false;
+    for (uint32_t k = 0; k < groups.size(); ++k) {
+        auto stale_begin = stale.begin() + k * num_aggregates;
+        if (groups[k].level != innermost_level ||
+            std::find(stale_begin, stale_begin + num_aggregates, 1) == stale_begin + num_aggregates) {
+            continue;
+        }
+        if (!groups[k].materialized) {
+            scan = true;
+            continue;
+        }
+        for (auto i : groups[k].rows) {
+            add_extremes(k, i);
+        }
+    }
+    for (int i = 0; scan && i < num_rows; ++i) {
+        auto k = cache.row_groups[i];
+        if (k != NO_GROUP && !groups[k].materialized) {
+            add_extremes(k, i);
+        }
+    }
+
+    for (auto k = (int)groups.size() - 1; k >= 0; --k) {
+        auto parent = groups[k].parent;
+        for (size_t a = 0; parent != -1 && a < num_aggregates; ++a) {
+            if (stale[parent * num_aggregates + a]) {
+                auto& aggregate = groups[parent].aggregates[a];
+                aggregate.min = std::min(aggregate.min, groups[k].aggregates[a].min);
+                aggregate.max = std::max(aggregate.max, groups[k].aggregates[a].max);
+            }
+        }
+    }
+    return true;
+}
+
+static int compare_keys(const SortKeyCache::Column& keys, int row1, int row2) {
+    auto begin1 = keys.offsets[row1], length1 = keys.offsets[row1 + 1] - begin1;
+    auto begin2 = keys.offsets[row2], length2 = keys.offsets[row2 + 1] - begin2;
+    auto diff = memcmp(keys.bytes.data() + begin1, keys.bytes.data() + begin2,
+                       std::min(length1, length2));
+    if (diff != 0) {
+        return diff;
+    }
+    return (length1 < length2 ? -1 : length1 > length2 ? 1 : 0);
+}
+
+void sort_rows(Model& model, const std::vector<SortKey>& sort_keys, std::vector<int>& rows,
+               SortKeyCache& sort_key_cache) {
+    std::vector<const SortKeyCache::Column*> levels;
+    for (auto& sort_key : sort_keys) {
+        column_sort_keys(model, sort_key.column, sort_key_cache);
+    }
+    for (auto& sort_key : sort_keys) {
+        levels.push_back(&sort_key_cache.columns[sort_key.column]);
+    }
+
+    // Pack the prefixes of the sort keys into one composite integer,
+    // most significant first, for as long as they fit. The first key
+    // that doesn't fit contributes its top bits. For a descending key,
+    // the bits are inverted rather than compared the other way, so that
+    // equal values still keep their model order.
+    struct Part {
+        const SortKeyCache::Column* keys;
+        bool ascending;
+        int bits, shift;
+        bool truncated; // only the top bits of the prefix fit
+    };
+    std::vector<Part> parts;
+    int free_bits = 64;
+    int tie_level = 0; // keys from here on aren't decided by the composite
+    for (; tie_level < levels.size() && free_bits > 0; ++tie_level) {
+        auto& keys = *levels[tie_level];
+        auto ascending = sort_keys[tie_level].ascending;
+        if (keys.exact && keys.prefix_bits <= free_bits) {
+            free_bits -= keys.prefix_bits;
+            if (keys.prefix_bits > 0) {
+                parts.push_back({ &keys, ascending, keys.prefix_bits, free_bits, false });
+            }
+            continue;
+        }
+        parts.push_back({ &keys, ascending, free_bits, 0, true });
+        break;
+    }
+
+    std::vector<SortEntry> entries(rows.size());
+    for (int k = 0; k < rows.size(); ++k) {
+        auto i = rows[k];
+        uint64_t key = 0;
+        for (auto& part : parts) {
+            auto mask = (part.bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << part.bits) - 1);
+            auto value = (part.truncated ?
+                          part.keys->prefixes[i] >> (64 - part.bits) :
+                          part.keys->prefixes[i] - part.keys->min_prefix);
+            key |= ((part.ascending ? value : ~value) & mask) << part.shift;
+        }
+        entries[k].key = key;
+        entries[k].row = i;
+    }
+
+    // Rows with equal composite keys are ordered by the remaining keys
+    std::function<void(SortEntry*, SortEntry*)> sort_ties;
+    if (tie_level < levels.size()) {
+        sort_ties = [&](SortEntry* begin, SortEntry* end) {
+            std::stable_sort(begin, end, [&](const SortEntry& l, const SortEntry& r) {
+                for (int level = tie_level; level < levels.size(); ++level) {
+                    auto& keys = *levels[level];
+                    auto direction = (sort_keys[level].ascending ? 1 : -1);
+                    auto prefix1 = keys.prefixes[l.row], prefix2 = keys.prefixes[r.row];
+                    if (prefix1 != prefix2) {
+                        return (prefix1 < prefix2 ? -1 : 1) * direction < 0;
+                    }
+                    if (!keys.exact) {
+                        auto diff = compare_keys(keys, l.row, r.row);
+                        if (diff != 0) {
+                            return diff * direction < 0;
+                        }
+                    }
+                }
+                return false;
+            });
+        };
+    }
+    radix_sort(entries, sort_ties);
+
+    for (int k = 0; k < entries.size(); ++k) {
+        rows[k] = entries[k].row;
+    }
+}
+
+// Compares two rows by the cells of a column, the same way sort_rows
+// orders them
+static int compare_cells(Model& model, int j, int row1, int row2, std::string& text) {
+    switch (model.column_type(j)) {
+        case Model::COLUMN_INT64:
+        case Model::COLUMN_TIMESTAMP: {
+            auto value1 = model.cell_int64(row1, j), value2 = model.cell_int64(row2, j);
+            return (value1 < value2 ? -1 : value1 > value2 ? 1 : 0);
+        }
+        case Model::COLUMN_DOUBLE: {
+            // NaN orders first, and -0.0 == 0.0
+            auto value1 = model.cell_double(row1, j), value2 = model.cell_double(row2, j);
+            if (value1 != value1 || value2 != value2) {
+                return (value2 == value2 ? -1 : value1 == value1 ? 1 : 0);
+            }
+            return (value1 < value2 ? -1 : value1 > value2 ? 1 : 0);
+        }
+        case Model::COLUMN_STRING:
+            break;
+    }
+
+    // The first view may not survive fetching the second
+    auto cell = model.cell_view(row1, j);
+    text.assign(cell.data(), cell.size());
+    return alphacmp(text, model.cell_view(row2, j));
+}
+
+// Merges new_rows into rows, which are sorted by sort_keys, as
+// sort_rows would have placed them. Equal rows stay in model order.
+void merge_rows(Model& model, const std::vector<SortKey>& sort_keys, std::vector<int>& rows,
+                std::vector<int>& new_rows) {
+    std::string text;
+    auto row_less = [&](int row1, int row2) {
+        for (auto& sort_key : sort_keys) {
+            auto diff = compare_cells(model, sort_key.column, row1, row2, text);
+            if (diff != 0) {
+                return (sort_key.ascending ? diff < 0 : diff > 0);
+            }
+        }
+        return row1 < row2;
+    };
+    std::sort(new_rows.begin(), new_rows.end(), row_less);
+
+    // Place a few rows by binary search, and merge in more
+    if (new_rows.size() <= MAX_BINARY_INSERTS) {
+        for (auto i : new_rows) {
+            rows.insert(std::upper_bound(rows.begin(), rows.end(), i, row_less), i);
+        }
+        return;
+    }
+    std::vector<int> merged(rows.size() + new_rows.size());
+    std::merge(rows.begin(), rows.end(), new_rows.begin(), new_rows.end(), merged.begin(), row_less);
+    rows = std::move(merged);
+}
+
+// Removes the given rows, which are sorted, from a bitmap of num_rows
+// rows by moving the rows between them down, up to 64 at a time
+void remove_rows(RowBitmap& bitmap, const std::vector<int>& removed, int num_rows) {
+    int output = removed.front();
+    for (size_t k = 0; k < removed.size(); ++k) {
+        int begin = removed[k] + 1;
+        int end = (k + 1 < removed.size() ? removed[k + 1] : num_rows);
+        while (begin < end) {
+            auto word = bitmap[begin / 64] >> (begin % 64);
+            if (begin % 64 != 0 && begin / 64 + 1 < bitmap.size()) {
+                word |= bitmap[begin / 64 + 1] << (64 - begin % 64);
+            }
+            auto shift = output % 64;
+            auto count = std::min(end - begin, 64 - shift);
+            auto mask = (count == 64 ? ~(uint64_t)0 : ((uint64_t)1 << count) - 1);
+            auto& target = bitmap[output / 64];
+            target = (target & ~(mask << shift)) | ((word & mask) << shift);
+            begin += count;
+            output += count;
+        }
+    }
+
+    bitmap.resize(bitmap_words(output));
+    if (output % 64 != 0) {
+        bitmap.back() &= ((uint64_t)1 << (output % 64)) - 1;
+    }
+}
+
+// Removes the elements at the given indices, which are sorted
+template <typename T>
+void remove_rows(std::vector<T>& values, const std::vector<int>& removed) {
+    auto output = values.begin() + removed.front();
+    for (size_t k = 0; k < removed.size(); ++k) {
+        auto begin = values.begin() + removed[k] + 1;
+        auto end = (k + 1 < removed.size() ? values.begin() + removed[k + 1] : values.end());
+        output = std::copy(begin, end, output);
+    }
+    values.erase(output, values.end());
+}
+
+// Marks the prefixes as deciding every comparison, and finds how many
+// bits they take up so they can be packed with those of other columns
+static void set_exact(SortKeyCache::Column& keys) {
+    keys.exact = true;
+    keys.min_prefix = 0;
+    keys.prefix_bits = 0;
+    if (keys.prefixes.empty()) {
+        return;
+    }
+    auto min_prefix = keys.prefixes[0], max_prefix = keys.prefixes[0];
+    for (auto prefix : keys.prefixes) {
+        min_prefix = std::min(min_prefix, prefix);
+        max_prefix = std::max(max_prefix, prefix);
+    }
+    keys.min_prefix = min_prefix;
+    for (auto range = max_prefix - min_prefix; range != 0; range >>= 1) {
+        ++keys.prefix_bits;
+    }
+}
+
+const SortKeyCache::Column& column_sort_keys(Model& model, int j, SortKeyCache& sort_key_cache) {
+    auto ref = model.ref();
+    auto num_rows = model.rows();
+
+    sort_key_cache.columns.resize(model.columns());
+    auto& keys = sort_key_cache.columns[j];
+    if (keys.ref == ref) {
+        return keys;
+    }
+
+    // Keys of other columns were made for an older model
+    for (auto& column : sort_key_cache.columns) {
+        if (column.ref != ref) {
+            column = SortKeyCache::Column();
+        }
+    }
+    keys.ref = ref;
+    keys.prefixes.resize(num_rows);
+
+    // Typed values map to integers that order the same way. Nulls
+    // (INT64_MIN and NaN) map to 0 and so order first.
+    switch (model.column_type(j)) {
+        case Model::COLUMN_INT64:
+        case Model::COLUMN_TIMESTAMP: {
+            for (int i = 0; i < num_rows; ++i) {
+                keys.prefixes[i] = (uint64_t)model.cell_int64(i, j) ^ ((uint64_t)1 << 63);
+            }
+            set_exact(keys);
+            return keys;
+        }
+        case Model::COLUMN_DOUBLE: {
+            for (int i = 0; i < num_rows; ++i) {
+                auto value = model.cell_double(i, j);
+                uint64_t bits = 0;
+                if (value == value) {
+                    value = (value == 0 ? 0.0 : value); // -0.0 == 0.0
+                    memcpy(&bits, &value, sizeof(bits));
+                    bits = ((bits >> 63) ? ~bits : bits | ((uint64_t)1 << 63));
+                }
+                keys.prefixes[i] = bits;
+            }
+            set_exact(keys);
+            return keys;
+        }
+        case Model::COLUMN_STRING:
+            break;
+    }
+
+    // For a dictionary encoded column, rank the distinct values once.
+    // Values that alphacmp considers equal share a rank.
+    if (model.column_has_dictionary(j)) {
+        std::vector<uint32_t> ids(model.dictionary_size(j));
+        for (uint32_t id = 0; id < ids.size(); ++id) {
+            ids[id] = id;
+        }
+        std::sort(ids.begin(), ids.end(), [&](uint32_t id1, uint32_t id2) {
+            return alphacmp_ascending(model.dictionary_text(j, id1), model.dictionary_text(j, id2));
+        });
+
+        std::vector<uint64_t> ranks(ids.size());
+        uint64_t rank = 0;
+        for (int k = 0; k < ids.size(); ++k) {
+            if (k > 0 && alphacmp(model.dictionary_text(j, ids[k - 1]), model.dictionary_text(j, ids[k])) != 0) {
+                ++rank;
+            }
+            ranks[ids[k]] = rank;
+        }
+
+        for_each_cell_id(model, j, [&](int i, uint32_t id) {
+            keys.prefixes[i] = ranks[id];
+        });
+        set_exact(keys);
+        return keys;
+    }
+
+    keys.offsets.resize(num_rows + 1);
+    keys.offsets[0] = 0;
+    for_each_cell(model, j, [&](int i, std::string_view cell) {
+        auto begin = keys.bytes.size();
+        alphacmp_sort_key(cell, keys.bytes);
+        keys.offsets[i + 1] = keys.bytes.size();
+
+        uint64_t prefix = 0;
+        for (int k = 0; k < 8; ++k) {
+            auto byte = (begin + k < keys.bytes.size() ? (unsigned char)keys.bytes[begin + k] : 0);
+            prefix = (prefix << 8) | byte;
+        }
+        keys.prefixes[i] = prefix;
+    });
+    keys.exact = false;
+    keys.min_prefix = 0;
+    keys.prefix_bits = 64;
+    return keys;
 }
 
 }
@@ -10,33 +10,63 @@
 #define ddui_table_settings_hpp
 
 #include "model.hpp"
+#include "row_bitmap.hpp"
+#include "aggregate.hpp"
 #include <map>
 
 namespace Table {
 
+// Maps of values use a transparent comparator so that they can be
+// searched with a std::string_view without allocating.
+typedef std::map<std::string, bool, std::less<>> ValueMap;
+
 struct ColumnFilter {
     bool enabled;
-    std::map<std::string, bool> allowed_values;
+    ValueMap allowed_values;
+};
+
+struct SortKey {
+    int column;
+    bool ascending;
 };
 
+inline bool operator==(const SortKey& l, const SortKey& r) {
+    return l.column == r.column && l.ascending == r.ascending;
+}
+
+inline bool operator!=(const SortKey& l, const SortKey& r) {
+    return !(l == r);
+}
+
 struct Settings {
     std::vector<float> column_widths;
     std::vector<bool> column_enabled;
     std::vector<int> column_ordering;
 
-    int sort_column = -1; // = -1 when unsorted
-    bool sort_ascending;
+    // Columns to sort by, most significant first. Empty when unsorted.
+    std::vector<SortKey> sort_keys;
 
     std::vector<ColumnFilter> filters;
 
-    int grouped_column = -1; // -1 when ungrouped
-    std::map<std::string, bool> group_collapsed;
+    // Columns to group by, outermost first. Empty when ungrouped.
+    std::vector<int> grouped_columns;
+    ValueMap group_collapsed; // by GroupHeading::key
+
+    // Numeric columns to total up for every group
+    std::vector<int> aggregated_columns;
+
+    // Deltas that change more than this fraction of the rows are
+    // applied by recomputing the results rather than incrementally
+    float max_delta_churn = 0.05f;
 };
 
 struct GroupHeading {
     int position;
+    int level; // index into Settings::grouped_columns
     std::string value;
+    std::string key; // the values of this group and its parents, encoded
     int count;
+    std::vector<Aggregate> aggregates; // one per Settings::aggregated_columns
 };
 
 struct Results {
@@ -45,7 +75,135 @@ struct Results {
     std::vector<GroupHeading> group_headings;
 };
 
+// Keeps the rows that pass each column's filter between calls to
+// apply_settings, so that only the filters which changed (or all of
+// them, when the model ref changes) have to be evaluated again.
+//
+// Filters are evaluated in chunks of rows spread over the shared
+// WorkerPool, for columns whose cells can be read concurrently.
+struct FilterCache {
+    struct Column {
+        long ref = -1; // model ref the bitmap was computed at
+        ValueMap allowed_values;
+        RowBitmap row_included;
+    };
+    std::vector<Column> columns;
+
+    // The AND of the bitmaps of combined_columns, which gets a new
+    // version number whenever it's recomputed
+    long ref = -1;
+    long version = 0;
+    std::vector<int> combined_columns;
+    RowBitmap row_included;
+};
+
+// A group of the results. Counting the rows of a group is cheap, but
+// its rows are only listed (and sorted) once it's shown expanded. Only
+// groups of the innermost level hold rows.
+struct Group {
+    int level = 0;
+    int parent = -1; // index of the enclosing group
+    std::string value;
+    std::string key;
+    int count = 0;
+    std::vector<Aggregate> aggregates; // one per ResultsCache::aggregated_columns
+    bool materialized = false;
+    std::vector<int> rows; // in sorted order, when materialized
+};
+
+typedef std::vector<Group> Groups;
+
+// Sort keys of columns, kept between sorts until the model ref changes.
+// Rows are radix sorted by the first 8 bytes of their key as an integer,
+// and compared by the whole key (see alphacmp_sort_key) only on ties.
+// For dictionary encoded columns the prefix is the rank of the cell's
+// value among the distinct values, and for typed columns it's the value
+// itself, so the prefix decides every comparison.
+//
+// When sorting by several columns, the prefixes of exact columns are
+// packed into one composite integer using only prefix_bits bits each,
+// so that the radix sort orders by as many columns as fit at once.
+struct SortKeyCache {
+    struct Column {
+        long ref = -1;
+        bool exact = false; // prefixes alone order the rows
+        uint64_t min_prefix = 0;
+        int prefix_bits = 64; // prefixes - min_prefix fit in this many bits
+        std::vector<uint64_t> prefixes;
+        std::vector<size_t> offsets; // key of row i is bytes[offsets[i], offsets[i + 1])
+        std::string bytes;
+    };
+    std::vector<Column> columns;
+};
+
+// Keeps the output of each stage of apply_settings between calls:
+//
+//   filter -> group -> sort -> collapse -> column projection
+//
+// A stage is only run again when its own inputs (the settings it reads
+// and the model ref) or an earlier stage's output changed. So sorting
+// doesn't re-filter, collapsing a group doesn't re-sort, and reordering
+// or hiding columns only redoes the O(columns) projection.
+//
+// Grouping only counts the rows of each group. The rows of a group are
+// listed and sorted when it's first laid out expanded, so collapsed
+// groups cost nothing beyond the grouping pass.
+//
+// Aggregates are kept with the groups. Adding an aggregated column only
+// totals up that column, reading its numbers from number_cache, and the
+// rows laid out by group in group_layout are reused until regrouping.
+struct ResultsCache {
+    FilterCache filter_cache;
+    SortKeyCache sort_key_cache;
+    NumberCache number_cache;
+
+    // Inputs the stages were last run with
+    long ref = -1;
+    long filtered_version = -1;
+    std::vector<int> grouped_columns;
+    std::vector<int> aggregated_columns;
+    std::vector<SortKey> sort_keys;
+    ValueMap group_collapsed;
+
+    // Rows that pass the filters, by group (a single group when
+    // ungrouped), and the innermost group of each row when grouped (~0
+    // for rows that don't pass the filters). Nested groups are listed
+    // in the order they're shown, each one followed by its subgroups.
+    Groups groups;
+    std::vector<uint32_t> row_groups;
+    GroupLayout group_layout; // empty until aggregates are needed
+    bool valid = false;
+
+    // Innermost groups by key, for placing changed rows in their group
+    std::unordered_map<std::string, uint32_t> group_index;
+};
+
 Results apply_settings(Model& model, Settings& settings);
+void update_results(Model& model, Settings& settings, ResultsCache& cache, Results& results);
+
+// Brings results computed by update_results for the model at since_ref
+// up to date with a delta, without re-sorting. Removed rows are dropped
+// and the rows after them renumbered. Rows that were appended or had a
+// filtered, grouped or sorted cell updated are taken out of their group
+// and merged back into the sorted rows of their new group, and their
+// numbers moved between the aggregates of the two groups. Returns
+// false, for update_results to recompute everything, when the settings
+// changed since, a group has to be added or removed, or more than
+// settings.max_delta_churn of the rows changed.
+bool update_results_from_delta(Model& model, Settings& settings, ResultsCache& cache, Results& results,
+                               long since_ref, const ModelDelta& delta);
+
+// Position of the column in settings.grouped_columns, or -1 when not
+// grouped by
+int group_level(Settings& settings, int column);
+
+// Position of the column in settings.sort_keys, or -1 when not sorted by
+int sort_key_index(Settings& settings, int column);
+
+// Sorts by the column in the given direction: a column that isn't a sort
+// key yet is appended as the least significant one, a key in the other
+// direction is flipped, and a key in the same direction is removed.
+void toggle_sort_key(Settings& settings, int column, bool ascending);
 
 }
 
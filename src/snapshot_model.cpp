@@ -0,0 +1,435 @@
+//
+//  snapshot_model.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "snapshot_model.hpp"
+#include "typed_value.hpp"
+#include <stdio.h>
+#include <string.h>
+
+namespace Table {
+
+// File layout. Every section starts at a multiple of 8 bytes, so that
+// it can be read in place from the mapping.
+//
+//   FileHeader
+//   sections, in the order they were written
+//   ColumnEntry[columns]
+//   uint32_t key[key_count]
+//
+// A string section is a byte section followed by a section of uint64
+// offsets, one per string plus one for the end.
+
+static const char MAGIC[8] = { 'D', 'D', 'T', 'A', 'B', 'L', 'E', 0 };
+static constexpr uint32_t FORMAT_VERSION = 1;
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct Section {
+    uint64_t offset;
+    uint64_t size; // in bytes
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t rows;
+    uint32_t columns;
+    uint32_t key_count;
+    Section directory; // column entries followed by the key
+};
+
+struct ColumnEntry {
+    uint32_t type;
+    uint32_t dictionary;
+    Section header_bytes;
+    Section header_offsets;
+    Section bytes;   // strings, or dictionary values
+    Section offsets;
+    Section ids;     // uint32_t per row, for dictionaries
+    Section values;  // int64_t or double per row, for typed columns
+};
+
+class SnapshotWriter {
+    public:
+        SnapshotWriter(const std::string& path) {
+            file = fopen(path.c_str(), "wb");
+            if (file == NULL) {
+                throw "Couldn't open table snapshot for writing";
+            }
+            setvbuf(file, NULL, _IOFBF, 1 << 20);
+            position = 0;
+        }
+        ~SnapshotWriter() {
+            if (file != NULL) {
+                fclose(file);
+            }
+        }
+
+        void write(const void* data, size_t size) {
+            if (size > 0 && fwrite(data, 1, size, file) != size) {
+                throw "Couldn't write table snapshot";
+            }
+            position += size;
+        }
+
+        Section write_section(const void* data, size_t size) {
+            static const char zeros[8] = { 0 };
+            write(zeros, (8 - position % 8) % 8);
+            Section section = { position, size };
+            write(data, size);
+            return section;
+        }
+
+        void rewrite_header(const FileHeader& header) {
+            if (fseek(file, 0, SEEK_SET) != 0 ||
+                fwrite(&header, sizeof(header), 1, file) != 1 ||
+                fclose(file) != 0) {
+                file = NULL;
+                throw "Couldn't write table snapshot";
+            }
+            file = NULL;
+        }
+
+        uint64_t position;
+
+    private:
+        FILE* file;
+};
+
+// Writes the strings given by `fetch` for [0, count) as a byte section
+// and an offset section, a chunk at a time
+template <typename Fetch>
+static void write_strings(SnapshotWriter& writer, int count, Section* bytes, Section* offsets,
+                          Fetch fetch) {
+    std::vector<uint64_t> string_offsets;
+    string_offsets.reserve(count + 1);
+    string_offsets.push_back(0);
+
+    *bytes = writer.write_section(NULL, 0);
+    std::vector<std::string_view> chunk(CELL_CHUNK_SIZE);
+    for (int begin = 0; begin < count; begin += CELL_CHUNK_SIZE) {
+        auto end = std::min(begin + CELL_CHUNK_SIZE, count);
+        fetch(begin, end, chunk.data());
+        for (int i = 0; i < end - begin; ++i) {
+            writer.write(chunk[i].data(), chunk[i].size());
+            string_offsets.push_back(string_offsets.back() + chunk[i].size());
+        }
+    }
+    bytes->size = string_offsets.back();
+
+    *offsets = writer.write_section(string_offsets.data(), string_offsets.size() * sizeof(uint64_t));
+}
+
+void save_table_snapshot(Model& model, const std::string& path) {
+    SnapshotWriter writer(path);
+
+    auto num_rows = model.rows();
+    auto num_cols = model.columns();
+    auto key = model.key();
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    writer.write(&header, sizeof(header));
+
+    std::vector<ColumnEntry> entries(num_cols);
+    for (int j = 0; j < num_cols; ++j) {
+        auto& entry = entries[j];
+        memset(&entry, 0, sizeof(entry));
+        entry.type = model.column_type(j);
+
+        write_strings(writer, 1, &entry.header_bytes, &entry.header_offsets,
+                      [&](int begin, int end, std::string_view* out) {
+            *out = model.header_text(j);
+        });
+
+        switch (model.column_type(j)) {
+            case Model::COLUMN_INT64:
+            case Model::COLUMN_TIMESTAMP: {
+                std::vector<int64_t> values(num_rows);
+                for (int i = 0; i < num_rows; ++i) {
+                    values[i] = model.cell_int64(i, j);
+                }
+                entry.values = writer.write_section(values.data(), values.size() * sizeof(int64_t));
+                continue;
+            }
+            case Model::COLUMN_DOUBLE: {
+                std::vector<double> values(num_rows);
+                for (int i = 0; i < num_rows; ++i) {
+                    values[i] = model.cell_double(i, j);
+                }
+                entry.values = writer.write_section(values.data(), values.size() * sizeof(double));
+                continue;
+            }
+            case Model::COLUMN_STRING:
+                break;
+        }
+
+        if (model.column_has_dictionary(j)) {
+            entry.dictionary = 1;
+            write_strings(writer, model.dictionary_size(j), &entry.bytes, &entry.offsets,
+                          [&](int begin, int end, std::string_view* out) {
+                for (int id = begin; id < end; ++id) {
+                    *out++ = model.dictionary_text(j, id);
+                }
+            });
+            std::vector<uint32_t> ids(num_rows);
+            if (num_rows > 0) {
+                model.cell_ids(j, 0, num_rows, ids.data());
+            }
+            entry.ids = writer.write_section(ids.data(), ids.size() * sizeof(uint32_t));
+            continue;
+        }
+
+        write_strings(writer, num_rows, &entry.bytes, &entry.offsets,
+                      [&](int begin, int end, std::string_view* out) {
+            model.cells(j, begin, end, out);
+        });
+    }
+
+    std::vector<uint32_t> key_columns(key.begin(), key.end());
+    header.directory = writer.write_section(entries.data(), entries.size() * sizeof(ColumnEntry));
+    writer.write(key_columns.data(), key_columns.size() * sizeof(uint32_t));
+    header.directory.size += key_columns.size() * sizeof(uint32_t);
+
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.rows = num_rows;
+    header.columns = num_cols;
+    header.key_count = key_columns.size();
+    writer.rewrite_header(header);
+}
+
+// Returns a pointer to the section, after checking that it lies within
+// the file and holds `count` elements of type T
+template <typename T>
+static const T* section_data(const MappedFile& file, const Section& section, uint64_t count) {
+    if (section.offset % 8 != 0 ||
+        section.offset > file.size() ||
+        section.size > file.size() - section.offset ||
+        section.size != count * sizeof(T)) {
+        throw "Table snapshot is corrupt";
+    }
+    return (const T*)(file.data() + section.offset);
+}
+
+// Checks the bounds of a string section with `count` strings and
+// returns its offsets. Only the first and last offsets are read, so
+// that the offsets of the cells aren't paged in at load.
+static const uint64_t* string_offsets(const MappedFile& file, const Section& bytes,
+                                      const Section& offsets, uint64_t count) {
+    section_data<char>(file, bytes, bytes.size);
+    auto data = section_data<uint64_t>(file, offsets, count + 1);
+    if (data[0] != 0 || data[count] != bytes.size) {
+        throw "Table snapshot is corrupt";
+    }
+    return data;
+}
+
+// Checks that every string of a string section lies within its bytes
+static void check_string_offsets(const uint64_t* offsets, uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            throw "Table snapshot is corrupt";
+        }
+    }
+}
+
+SnapshotModel::SnapshotModel(const std::string& path) : file(path) {
+    scratch_index = 0;
+
+    file.advise_sequential();
+
+    // Step 1. Check the header
+    FileHeader header;
+    if (file.size() < sizeof(header)) {
+        throw "Table snapshot is corrupt";
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw "File is not a table snapshot";
+    }
+    if (header.version != FORMAT_VERSION || header.byte_order != BYTE_ORDER_MARK) {
+        throw "Table snapshot was written in an unsupported format";
+    }
+    if (header.rows > INT32_MAX || header.columns == 0) {
+        throw "Table snapshot is corrupt";
+    }
+    num_rows = header.rows;
+
+    // Step 2. Read the directory
+    auto directory = header.directory;
+    auto entries_size = header.columns * sizeof(ColumnEntry);
+    if (directory.size != entries_size + header.key_count * sizeof(uint32_t)) {
+        throw "Table snapshot is corrupt";
+    }
+    directory.size = entries_size;
+    auto entries = section_data<ColumnEntry>(file, directory, header.columns);
+
+    Section key_section = { directory.offset + entries_size, header.key_count * sizeof(uint32_t) };
+    auto key_columns = section_data<uint32_t>(file, key_section, header.key_count);
+    for (uint32_t k = 0; k < header.key_count; ++k) {
+        if (key_columns[k] >= header.columns) {
+            throw "Table snapshot is corrupt";
+        }
+        key_.push_back(key_columns[k]);
+    }
+
+    // Step 3. Point each column into the mapping
+    data.resize(header.columns);
+    for (int j = 0; j < header.columns; ++j) {
+        auto& entry = entries[j];
+        auto& column = data[j];
+        column.offsets = NULL;
+        column.bytes = NULL;
+        column.bytes_size = 0;
+        column.ids = NULL;
+        column.ints = NULL;
+        column.doubles = NULL;
+
+        auto offsets = string_offsets(file, entry.header_bytes, entry.header_offsets, 1);
+        check_string_offsets(offsets, 1);
+        headers.push_back(std::string(file.data() + entry.header_bytes.offset, offsets[1]));
+
+        column.type = (ColumnType)entry.type;
+        switch (column.type) {
+            case COLUMN_INT64:
+            case COLUMN_TIMESTAMP:
+                column.ints = section_data<int64_t>(file, entry.values, num_rows);
+                continue;
+            case COLUMN_DOUBLE:
+                column.doubles = section_data<double>(file, entry.values, num_rows);
+                continue;
+            case COLUMN_STRING:
+                break;
+            default:
+                throw "Table snapshot is corrupt";
+        }
+
+        if (entry.dictionary) {
+            if (entry.offsets.size < sizeof(uint64_t)) {
+                throw "Table snapshot is corrupt";
+            }
+            auto dictionary_size = entry.offsets.size / sizeof(uint64_t) - 1;
+            auto offsets = string_offsets(file, entry.bytes, entry.offsets, dictionary_size);
+            check_string_offsets(offsets, dictionary_size);
+            auto bytes = file.data() + entry.bytes.offset;
+            for (uint64_t id = 0; id < dictionary_size; ++id) {
+                column.values.push_back(std::string(bytes + offsets[id], offsets[id + 1] - offsets[id]));
+            }
+            column.ids = section_data<uint32_t>(file, entry.ids, num_rows);
+            continue;
+        }
+
+        column.offsets = string_offsets(file, entry.bytes, entry.offsets, num_rows);
+        column.bytes = file.data() + entry.bytes.offset;
+        column.bytes_size = entry.bytes.size;
+    }
+
+    file.advise_random();
+}
+
+void SnapshotModel::verify() {
+    for (auto& column : data) {
+        if (column.ids != NULL) {
+            for (int i = 0; i < num_rows; ++i) {
+                checked_id(column, i);
+            }
+        } else if (column.offsets != NULL) {
+            check_string_offsets(column.offsets, num_rows);
+        }
+    }
+}
+
+uint32_t SnapshotModel::cell_id(int row, int col) {
+    return checked_id(data[col], row);
+}
+
+void SnapshotModel::cell_ids(int col, int row_begin, int row_end, uint32_t* out) {
+    auto& column = data[col];
+    for (int i = row_begin; i < row_end; ++i) {
+        *out++ = checked_id(column, i);
+    }
+}
+
+const std::string& SnapshotModel::cell_text(int row, int col) {
+    auto& column = data[col];
+    if (column.ids != NULL) {
+        return column.values[checked_id(column, row)];
+    }
+
+    auto& text = scratch[scratch_index];
+    scratch_index = (scratch_index + 1) % SCRATCH_SLOTS;
+    format_cell(column, row, text);
+    return text;
+}
+
+std::string_view SnapshotModel::cell_view(int row, int col) {
+    auto& column = data[col];
+    if (column.ids != NULL) {
+        return column.values[checked_id(column, row)];
+    }
+    if (column.type != COLUMN_STRING) {
+        return cell_text(row, col);
+    }
+    return string_cell(column, row);
+}
+
+void SnapshotModel::cells(int col, int row_begin, int row_end, std::string_view* out) {
+    auto& column = data[col];
+
+    if (column.type != COLUMN_STRING) {
+        auto& scratch = column.bulk_scratch;
+        if (scratch.size() < row_end - row_begin) {
+            scratch.resize(row_end - row_begin);
+        }
+        for (int i = row_begin; i < row_end; ++i) {
+            auto& text = scratch[i - row_begin];
+            format_cell(column, i, text);
+            *out++ = text;
+        }
+        return;
+    }
+
+    for (int i = row_begin; i < row_end; ++i) {
+        *out++ = cell_view(i, col);
+    }
+}
+
+void SnapshotModel::format_cell(const Column& column, int row, std::string& text) {
+    switch (column.type) {
+        case COLUMN_INT64:     format_int64(column.ints[row], text); break;
+        case COLUMN_DOUBLE:    format_double(column.doubles[row], text); break;
+        case COLUMN_TIMESTAMP: format_timestamp(column.ints[row], text); break;
+        case COLUMN_STRING: {
+            auto cell = string_cell(column, row);
+            text.assign(cell.data(), cell.size());
+            break;
+        }
+    }
+}
+
+// Cells are checked as they're read rather than at load, which would
+// page in the whole file
+std::string_view SnapshotModel::string_cell(const Column& column, int row) {
+    auto begin = column.offsets[row], end = column.offsets[row + 1];
+    if (begin > end || end > column.bytes_size) {
+        throw "Table snapshot is corrupt";
+    }
+    return std::string_view(column.bytes + begin, end - begin);
+}
+
+uint32_t SnapshotModel::checked_id(const Column& column, int row) {
+    auto id = column.ids[row];
+    if (id >= column.values.size()) {
+        throw "Table snapshot is corrupt";
+    }
+    return id;
+}
+
+}
@@ -0,0 +1,124 @@
+//
+//  snapshot_model.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_snapshot_model_hpp
+#define ddui_table_snapshot_model_hpp
+
+#include "model.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+
+namespace Table {
+
+// Writes the contents of a model (headers, key and every cell) to a
+// binary snapshot file that SnapshotModel can map back in. Dictionary
+// and typed columns are written in their encoded form. The file is in
+// the byte order of the machine writing it.
+void save_table_snapshot(Model& model, const std::string& path);
+
+// A read-only model over a memory-mapped snapshot file. Loading only
+// checks the file layout and reads the headers and dictionaries, the
+// cells are read straight from the mapping. The offset or dictionary
+// id of a cell is checked when the cell is read, and verify() checks
+// them all up front (which reads the whole file).
+//
+// String and dictionary cells are viewed in place by cell_view() and
+// cells(). Typed cells are formatted on demand, into a small ring of
+// scratch strings like ColumnarModel does.
+class SnapshotModel : public Model {
+    public:
+        SnapshotModel(const std::string& path);
+
+        // Throws if any cell lies outside its column's data
+        void verify();
+
+        // Implement Model methods
+        long ref() {
+            return 1; // the file is never reloaded
+        }
+        int columns() {
+            return headers.size();
+        }
+        int rows() {
+            return num_rows;
+        }
+        const std::string& header_text(int col) {
+            return headers[col];
+        }
+        const std::string& cell_text(int row, int col);
+        std::string_view cell_view(int row, int col);
+        void cells(int col, int row_begin, int row_end, std::string_view* out);
+        std::vector<int> key() {
+            return key_;
+        }
+        void set_cell_text(int row, int col, const std::string& text) {
+            throw "SnapshotModel is read-only";
+        }
+        bool column_has_dictionary(int col) {
+            return data[col].ids != NULL;
+        }
+        int dictionary_size(int col) {
+            return data[col].values.size();
+        }
+        const std::string& dictionary_text(int col, uint32_t id) {
+            return data[col].values[id];
+        }
+        uint32_t cell_id(int row, int col);
+        void cell_ids(int col, int row_begin, int row_end, uint32_t* out);
+        ColumnType column_type(int col) {
+            return data[col].type;
+        }
+        int64_t cell_int64(int row, int col) {
+            return data[col].ints[row];
+        }
+        double cell_double(int row, int col) {
+            return data[col].doubles[row];
+        }
+        bool concurrent_cells(int col) {
+            return data[col].type == COLUMN_STRING; // typed cells are formatted into scratch strings
+        }
+
+    private:
+        struct Column {
+            ColumnType type;
+
+            // String storage, cell i is bytes[offsets[i], offsets[i + 1])
+            const uint64_t* offsets;
+            const char* bytes;
+            uint64_t bytes_size;
+
+            // Dictionary storage
+            const uint32_t* ids;
+            std::vector<std::string> values;
+
+            // Typed storage
+            const int64_t* ints; // INT64 and TIMESTAMP
+            const double* doubles;
+
+            // Formatted text of typed cells handed out by cells()
+            std::vector<std::string> bulk_scratch;
+        };
+
+        static constexpr int SCRATCH_SLOTS = 16;
+
+        void format_cell(const Column& column, int row, std::string& text);
+        static std::string_view string_cell(const Column& column, int row);
+        static uint32_t checked_id(const Column& column, int row);
+
+        MappedFile file;
+        int num_rows;
+        std::vector<std::string> headers;
+        std::vector<Column> data;
+        std::vector<int> key_;
+        std::string scratch[SCRATCH_SLOTS];
+        int scratch_index;
+};
+
+}
+
+#endif
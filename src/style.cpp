@@ -29,6 +29,7 @@ float TEXT_SIZE_ROW = 14;
 float TEXT_SIZE_HEADER = 14;
 float TEXT_SIZE_GROUP_HEADING = 14;
 float GROUP_HEADING_MARGIN = 10;
+float GROUP_HEADING_INDENT = 20;
 
 // Filter overlay
 namespace filter_overlay {
@@ -32,6 +32,7 @@ extern float TEXT_SIZE_ROW;
 extern float TEXT_SIZE_HEADER;
 extern float TEXT_SIZE_GROUP_HEADING;
 extern float GROUP_HEADING_MARGIN;
+extern float GROUP_HEADING_INDENT;
 
 // Filter overlay
 namespace filter_overlay {
@@ -0,0 +1,244 @@
+//
+//  typed_value.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "typed_value.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Table {
+
+static inline bool is_digit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+bool parse_int64(const std::string& text, int64_t* value) {
+    if (text.empty()) {
+        *value = NULL_INT64;
+        return true;
+    }
+
+    auto ch = text.c_str();
+    bool negative = false;
+    if (*ch == '-' || *ch == '+') {
+        negative = (*ch == '-');
+        ++ch;
+    }
+    if (!is_digit(*ch)) {
+        return false;
+    }
+
+    // Accumulate as a negative number, which has the larger range
+    int64_t result = 0;
+    for (; is_digit(*ch); ++ch) {
+        auto digit = *ch - '0';
+        if (result < (INT64_MIN + digit) / 10) {
+            return false;
+        }
+        result = result * 10 - digit;
+    }
+    if (*ch != '\0') {
+        return false;
+    }
+
+    if (!negative) {
+        if (result == INT64_MIN) {
+            return false;
+        }
+        result = -result;
+    }
+    if (result == NULL_INT64) {
+        return false;
+    }
+
+    *value = result;
+    return true;
+}
+
+bool parse_double(const std::string& text, double* value) {
+    if (text.empty()) {
+        *value = NAN;
+        return true;
+    }
+
+    char* end;
+    auto result = strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || isnan(result)) {
+        return false;
+    }
+
+    *value = result;
+    return true;
+}
+
+// Conversions between civil dates and days since the epoch, from
+// http://howardhinnant.github.io/date_algorithms.html
+
+static int64_t days_from_civil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t* y, int* m, int* d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = yoe + era * 400 + (*m <= 2);
+}
+
+static bool read_fixed(const char** str, int digits, int* value) {
+    int result = 0;
+    for (int i = 0; i < digits; ++i) {
+        auto ch = (*str)[i];
+        if (!is_digit(ch)) {
+            return false;
+        }
+        result = result * 10 + (ch - '0');
+    }
+    *str += digits;
+    *value = result;
+    return true;
+}
+
+static bool read_char(const char** str, char expected) {
+    if (**str != expected) {
+        return false;
+    }
+    ++*str;
+    return true;
+}
+
+bool parse_timestamp(const std::string& text, int64_t* value) {
+    if (text.empty()) {
+        *value = NULL_INT64;
+        return true;
+    }
+
+    auto ch = text.c_str();
+    int year, month, day, hour = 0, minute = 0, second = 0, micros = 0;
+
+    if (!read_fixed(&ch, 4, &year) || !read_char(&ch, '-') ||
+        !read_fixed(&ch, 2, &month) || !read_char(&ch, '-') ||
+        !read_fixed(&ch, 2, &day)) {
+        return false;
+    }
+
+    if (*ch == ' ' || *ch == 'T') {
+        ++ch;
+        if (!read_fixed(&ch, 2, &hour) || !read_char(&ch, ':') ||
+            !read_fixed(&ch, 2, &minute)) {
+            return false;
+        }
+        if (read_char(&ch, ':')) {
+            if (!read_fixed(&ch, 2, &second)) {
+                return false;
+            }
+            if (read_char(&ch, '.')) {
+                if (!is_digit(*ch)) {
+                    return false;
+                }
+                int scale = 100000;
+                for (; is_digit(*ch); ++ch) {
+                    micros += (*ch - '0') * scale;
+                    scale /= 10;
+                }
+            }
+        }
+    }
+    read_char(&ch, 'Z');
+
+    if (*ch != '\0') {
+        return false;
+    }
+
+    static const int DAYS_IN_MONTH[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (month < 1 || month > 12 || day < 1 || day > DAYS_IN_MONTH[month - 1] ||
+        (month == 2 && day == 29 && !leap) ||
+        hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    auto days = days_from_civil(year, month, day);
+    auto seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+    *value = seconds * 1000000 + micros;
+    return true;
+}
+
+void format_int64(int64_t value, std::string& text) {
+    if (value == NULL_INT64) {
+        text.clear();
+        return;
+    }
+
+    char buffer[24];
+    auto length = snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+    text.assign(buffer, length);
+}
+
+void format_double(double value, std::string& text) {
+    if (isnan(value)) {
+        text.clear();
+        return;
+    }
+
+    // Use the shortest precision that reads back as the same value
+    char buffer[32];
+    auto length = snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (strtod(buffer, NULL) != value) {
+        length = snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    text.assign(buffer, length);
+}
+
+void format_timestamp(int64_t value, std::string& text) {
+    if (value == NULL_INT64) {
+        text.clear();
+        return;
+    }
+
+    auto seconds = value / 1000000;
+    auto micros = value % 1000000;
+    if (micros < 0) {
+        micros += 1000000;
+        seconds -= 1;
+    }
+    auto days = seconds / 86400;
+    auto time = seconds % 86400;
+    if (time < 0) {
+        time += 86400;
+        days -= 1;
+    }
+
+    int64_t year;
+    int month, day;
+    civil_from_days(days, &year, &month, &day);
+
+    char buffer[48];
+    auto length = snprintf(buffer, sizeof(buffer), "%04lld-%02d-%02d %02d:%02d:%02d",
+                           (long long)year, month, day,
+                           (int)(time / 3600), (int)(time / 60 % 60), (int)(time % 60));
+    if (micros != 0) {
+        length += snprintf(buffer + length, sizeof(buffer) - length, ".%06d", (int)micros);
+        while (buffer[length - 1] == '0') {
+            --length;
+        }
+    }
+    text.assign(buffer, length);
+}
+
+}
@@ -0,0 +1,38 @@
+//
+//  typed_value.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_typed_value_hpp
+#define ddui_table_typed_value_hpp
+
+#include <string>
+#include <stdint.h>
+
+namespace Table {
+
+// Parsing and formatting of typed cell values. An empty string is the
+// null value of every type: NULL_INT64 for integers and timestamps,
+// and NaN for doubles. Nulls order before every other value.
+//
+// Timestamps are microseconds since the Unix epoch (UTC). They parse
+// from "YYYY-MM-DD", optionally followed by ' ' or 'T' and
+// "HH:MM[:SS[.ffffff]]" and an optional 'Z'. They format as
+// "YYYY-MM-DD HH:MM:SS" with a fraction only when it is non-zero.
+
+constexpr int64_t NULL_INT64 = INT64_MIN;
+
+bool parse_int64(const std::string& text, int64_t* value);
+bool parse_double(const std::string& text, double* value);
+bool parse_timestamp(const std::string& text, int64_t* value);
+
+void format_int64(int64_t value, std::string& text);
+void format_double(double value, std::string& text);
+void format_timestamp(int64_t value, std::string& text);
+
+}
+
+#endif
@@ -9,10 +9,12 @@
 #include "view.hpp"
 #include "style.hpp"
 #include "filter.hpp"
+#include "typed_value.hpp"
 #include <ddui/util/draw_text_in_box>
 #include <ddui/util/entypo>
 #include <ddui/views/ContextMenu>
 #include <ddui/views/Overlay>
+#include <algorithm>
 
 namespace Table {
 
@@ -20,6 +22,16 @@ using namespace ddui;
 
 static void refresh_model(State* state);
 void refresh_results(State* state);
+static std::vector<bool> dictionary_ids_used(Model* model, int j);
+static ValueMap build_column_values(Model* model, int j);
+static void insert_value(ValueMap& values, std::string_view value);
+void refresh_column_values(State* state, int j);
+static void refresh_selection(State* state);
+static bool row_has_key(Model* model, int i, const std::vector<int>& key,
+                        const std::vector<std::string>& key_values);
+static void apply_model_delta(State* state, const ModelDelta& delta);
+static void remap_removed_rows(State* state, const ModelDelta& delta);
+static void update_results_layout(State* state);
 static float calculate_table_width(State* table_state);
 static void update_function_bar(State* state, float* bar_height);
 static void update_table_content(State* state, float outer_width, float outer_height);
@@ -36,6 +48,7 @@ State::State() {
 
     source = NULL;
     private_copy_ref = -1;
+    private_copy_source = NULL;
 
     column_resizing.active_column = -1;
     filter_overlay.active_column = -1;
@@ -193,11 +206,11 @@ void update(State* state) {
             });
 
         // Reset Grouping item
-        if (state->settings.grouped_column != -1) {
+        if (!state->settings.grouped_columns.empty()) {
             menu.item("Reset Grouping")
                 .action([state]() {
                     state->settings_changed = true;
-                    state->settings.grouped_column = -1;
+                    state->settings.grouped_columns.clear();
                     state->settings.group_collapsed.clear();
                     refresh_results(state);
                 });
@@ -267,7 +280,6 @@ void update(State* state) {
         !has_focus(&state->editable_field.state) &&
         state->selection.row != -1) {
         clear_selection(state);
-        refresh_results(state);
         repaint("Overlay::update(3)");
     }
 
@@ -281,7 +293,6 @@ void update(State* state) {
                              state->selection.candidate_column);
         state->editable_field.is_waiting_for_second_click = true;
         state->editable_field.click_time = std::chrono::high_resolution_clock::now();
-        refresh_results(state);
         repaint("Overlay::update(4)");
     }
     if (state->selection.row != -1 && mouse_hit(0, 0, view.width, view.height)) {
@@ -290,7 +301,6 @@ void update(State* state) {
         }
         mouse_hit_accept();
         clear_selection(state);
-        refresh_results(state);
         repaint("Overlay::update(5)");
     }
 
@@ -453,14 +463,18 @@ void update_column_header(State* state, int j, float& x, float y) {
         font_face("entypo");
         font_size(24.0);
 
+        auto sort_key = sort_key_index(settings, j);
+        auto sorted = (sort_key != -1);
+        auto ascending = (sorted && settings.sort_keys[sort_key].ascending);
+
         auto icon_text = (
             settings.filters[j].enabled ? (
-                settings.sort_column == j ? (
-                    settings.sort_ascending ? ICON_ASC_FILT : ICON_DESC_FILT
+                sorted ? (
+                    ascending ? ICON_ASC_FILT : ICON_DESC_FILT
                 ) : ICON_FILT
             ) : (
-                settings.sort_column == j ? (
-                    settings.sort_ascending ? ICON_ASC : ICON_DESC
+                sorted ? (
+                    ascending ? ICON_ASC : ICON_DESC
                 ) : ICON_NONE
             )
         );
@@ -474,7 +488,7 @@ void update_column_header(State* state, int j, float& x, float y) {
         text_bounds(0, 0, icon_text, 0, bounds);
         icon_size = bounds[2] - bounds[0] + 2 * MARGIN;
         
-        if (settings.filters[j].enabled || settings.sort_column == j) {
+        if (settings.filters[j].enabled || sorted) {
             fill_color(style::COLOR_TEXT_HEADER);
         } else {
             fill_color(style::COLOR_BG_ROW_ODD);
@@ -592,8 +606,33 @@ void update_column_separators(State* state) {
     }
 }
 
+// Formats the aggregates of a group heading as, for example,
+// "   Qty: sum 1200  avg 40  min 5  max 90"
+static std::string format_aggregates(State* state, const GroupHeading& heading) {
+    auto& settings = state->settings;
+    std::string text, number;
+    auto count = std::min(heading.aggregates.size(), settings.aggregated_columns.size());
+    for (size_t a = 0; a < count; ++a) {
+        auto& aggregate = heading.aggregates[a];
+        text += "   " + state->source->header_text(settings.aggregated_columns[a]) + ":";
+        if (aggregate.count == 0) {
+            text += " -";
+            continue;
+        }
+        format_double(aggregate.sum, number);
+        text += " sum " + number;
+        format_double(aggregate.mean(), number);
+        text += "  avg " + number;
+        format_double(aggregate.min, number);
+        text += "  min " + number;
+        format_double(aggregate.max, number);
+        text += "  max " + number;
+    }
+    return text;
+}
+
 void update_group_headings(State* state) {
-    if (state->settings.grouped_column == -1) {
+    if (state->settings.grouped_columns.empty()) {
         return;
     }
 
@@ -613,27 +652,31 @@ void update_group_headings(State* state) {
     text_metrics(&ascender, &descender, &line_height);
     text_bounds(0, 0, entypo::BLACK_DOWNPOINTING_SMALL_TRIANGLE, NULL, bounds);
     auto x = state->scroll_area_state.scroll_x;
-    auto button_x = x + style::GROUP_HEADING_MARGIN;
     auto button_y = (style::CELL_HEIGHT - line_height) / 2 + ascender;
     auto button_width = bounds[2] - bounds[0];
     
-    // Prepare & measure text
-    auto header_text = model.header_text(settings.grouped_column);
-    char buffer1[header_text.size() + 10];
-    char buffer2[10];
-    sprintf(buffer1, "  %s:  ", header_text.c_str());
-    
+    // Prepare & measure the column text of each level
     font_face("regular");
     font_size(style::TEXT_SIZE_GROUP_HEADING);
     text_metrics(&ascender, &descender, &line_height);
-    text_bounds(0, 0, buffer1, NULL, bounds);
     auto text_y = (style::CELL_HEIGHT - line_height) / 2 + ascender;
-    auto column_text_x = button_x + button_width;
-    auto column_text_width = bounds[2] - bounds[0];
+
+    std::vector<std::string> column_texts;
+    std::vector<float> column_text_widths;
+    for (auto j : settings.grouped_columns) {
+        column_texts.push_back("  " + model.header_text(j) + ":  ");
+        text_bounds(0, 0, column_texts.back().c_str(), NULL, bounds);
+        column_text_widths.push_back(bounds[2] - bounds[0]);
+    }
+    char buffer2[16];
     
     for (auto& heading : results.group_headings) {
-        auto collapsed = settings.group_collapsed[heading.value];
+        auto collapsed = settings.group_collapsed[heading.key];
         auto y = (1 + heading.position) * style::CELL_HEIGHT;
+        auto j = settings.grouped_columns[heading.level];
+        auto button_x = x + style::GROUP_HEADING_MARGIN + heading.level * style::GROUP_HEADING_INDENT;
+        auto column_text_x = button_x + button_width;
+        auto column_text_width = column_text_widths[heading.level];
         float clip_width, clip_height;
         get_clip_dimensions(&clip_width, &clip_height);
         
@@ -661,7 +704,7 @@ void update_group_headings(State* state) {
         if (mouse_hit(button_x - 2, y, button_width + 2, style::CELL_HEIGHT)) {
             mouse_hit_accept();
             state->settings_changed = true;
-            settings.group_collapsed[heading.value] = !collapsed;
+            settings.group_collapsed[heading.key] = !collapsed;
             refresh_results(state);
             repaint("Overlay::update_group_headings");
             return;
@@ -681,17 +724,17 @@ void update_group_headings(State* state) {
         }
         if (mouse_hit(column_text_x, y, column_text_width, style::CELL_HEIGHT)) {
             mouse_hit_accept();
-            state->filter_overlay.active_column = settings.grouped_column;
+            state->filter_overlay.active_column = j;
             to_global_position(&state->filter_overlay.x, &state->filter_overlay.y,
                                column_text_x + column_text_width / 2,
                                y + style::CELL_HEIGHT - 2);
-            state->filter_overlay.value_list = prepare_filter_value_list(state, settings.grouped_column);
+            state->filter_overlay.value_list = prepare_filter_value_list(state, j);
             state->filter_overlay.scroll_area_state = ScrollArea::ScrollAreaState();
             Overlay::open(state);
         }
         font_face("regular");
         font_size(style::TEXT_SIZE_GROUP_HEADING);
-        text(column_text_x, y + text_y, buffer1, NULL);
+        text(column_text_x, y + text_y, column_texts[heading.level].c_str(), NULL);
         
         // Draw value text
         font_face("bold");
@@ -706,6 +749,15 @@ void update_group_headings(State* state) {
         auto count_text_x = value_text_x + value_text_width;
         sprintf(buffer2, " (%d)", heading.count);
         text(count_text_x, y + text_y, buffer2, NULL);
+
+        // Draw aggregates text
+        if (heading.aggregates.empty()) {
+            continue;
+        }
+        text_bounds(0, 0, buffer2, NULL, bounds);
+        auto aggregates_text_x = count_text_x + (bounds[2] - bounds[0]);
+        fill_color(style::COLOR_TEXT_GROUP_HEADING);
+        text(aggregates_text_x, y + text_y, format_aggregates(state, heading).c_str(), NULL);
     }
     
 }
@@ -716,9 +768,21 @@ void refresh_model(State* state) {
         return; // No source data to refresh
     }
 
-    if (model->ref() == state->private_copy_ref) {
+    model->begin_update();
+
+    // Read the ref once, so that everything below is rebuilt against
+    // the same version of the model
+    auto ref = model->ref();
+    auto source_changed = (model != state->private_copy_source);
+    if (!source_changed && ref == state->private_copy_ref) {
         return; // Model is up-to-date
     }
+
+    // Refs (and the deltas between them) only mean something for the
+    // model they came from, so results cached for another model go
+    if (source_changed) {
+        state->results_cache = ResultsCache();
+    }
     
     auto& settings = state->settings;
 
@@ -765,9 +829,12 @@ void refresh_model(State* state) {
             settings.filters.push_back(empty_filter);
         }
         
-        settings.sort_column = -1;
+        settings.sort_keys.clear();
+
+        settings.grouped_columns.clear();
+        settings.aggregated_columns.clear();
 
-        settings.grouped_column = -1;
+        state->results_cache = ResultsCache();
         
         state->headers.clear();
         for (int j = 0; j < num_cols; ++j) {
@@ -777,19 +844,21 @@ void refresh_model(State* state) {
         clear_selection(state);
     }
 
+    // Bring the derived state up to date from a delta if the model can
+    // describe its changes, otherwise rebuild everything
+    ModelDelta delta;
+    if (!headers_changed && !source_changed && model->delta(state->private_copy_ref, &delta)) {
+        apply_model_delta(state, delta);
+        state->private_copy_ref = ref;
+        return;
+    }
+
     // Find all column values
     state->column_values.clear();
     for (int j = 0; j < model->columns(); ++j) {
-        std::map<std::string, bool> values;
-        
-        for (int i = 0; i < model->rows(); ++i) {
-            if (values.find(model->cell_text(i, j)) == values.end()) {
-                values.insert(std::make_pair(model->cell_text(i, j), true));
-            }
-        }
-        
-        state->column_values.push_back(std::move(values));
+        state->column_values.push_back(build_column_values(model, j));
     }
+    state->column_values_stale.assign(model->columns(), false);
     
     // If the overlay is open, update the value list
     if (state->filter_overlay.active_column != -1) {
@@ -797,78 +866,187 @@ void refresh_model(State* state) {
     }
 
     // If there's an active selection, update it
-    if (state->selection.row != -1) {
-        auto key = model->key();
+    refresh_selection(state);
 
-        // No key, simply index based
-        if (key.empty()) {
-            
-            // Reset the selection if the row doesn't exist
-            if (state->selection.row >= model->rows()) {
-                clear_selection(state);
-            }
-        } else {
+    state->private_copy_ref = ref;
+    state->private_copy_source = model;
 
-            // Since it's key-based, we have to find the new
-            // index.
-            bool found = false;
-            for (int i = 0; i < model->rows(); ++i) {
-                bool match = true;
-                for (int j = 0; j < key.size(); ++j) {
-                    if (model->cell_text(i, key[j]) != state->selection.row_key[j]) {
-                        match = false;
-                        break;
-                    }
-                }
-                if (match) {
-                    found = true;
-                    if (state->selection.row != i) {
-                        set_selection(state, i, state->selection.column);
-                    } 
-                    break;
-                }
-            }
+    refresh_results(state);
+}
+
+ValueMap build_column_values(Model* model, int j) {
+    ValueMap values;
 
-            // Row no longer exists, clear the selection
-            if (!found) {
-                clear_selection(state);
+    // For dictionary encoded columns, mark the ids in use and only
+    // insert those into the map
+    if (model->column_has_dictionary(j)) {
+        auto ids_used = dictionary_ids_used(model, j);
+        for (int id = 0; id < ids_used.size(); ++id) {
+            if (ids_used[id]) {
+                values.insert(std::make_pair(model->dictionary_text(j, id), true));
             }
         }
+        return values;
     }
+    
+    for_each_cell(*model, j, [&](int i, std::string_view cell) {
+        insert_value(values, cell);
+    });
 
-    state->private_copy_ref = model->ref();
+    return values;
+}
 
-    refresh_results(state);
+void insert_value(ValueMap& values, std::string_view value) {
+    if (values.find(value) == values.end()) {
+        values.insert(std::make_pair(std::string(value), true));
+    }
 }
 
-void refresh_results(State* state) {
+void refresh_selection(State* state) {
     auto model = state->source;
-    auto& settings = state->settings;
+    if (state->selection.row == -1) {
+        return;
+    }
+
+    auto key = model->key();
+
+    // No key, simply index based
+    if (key.empty()) {
+
+        // Reset the selection if the row doesn't exist
+        if (state->selection.row >= model->rows()) {
+            clear_selection(state);
+        }
+        return;
+    }
 
-    // If we're grouping, update the group_collapsed map
-    if (settings.grouped_column != -1) {
+    // Most of the time the row is still where it was
+    if (state->selection.row < model->rows() &&
+        row_has_key(model, state->selection.row, key, state->selection.row_key)) {
+        return;
+    }
+
+    // Since it's key-based, we have to find the new
+    // index.
+    for (int i = 0; i < model->rows(); ++i) {
+        if (row_has_key(model, i, key, state->selection.row_key)) {
+            set_selection(state, i, state->selection.column);
+            return;
+        }
+    }
 
-        auto j = settings.grouped_column;
+    // Row no longer exists, clear the selection
+    clear_selection(state);
+}
 
-        auto previous_group_collapsed = std::move(settings.group_collapsed);
-        auto next_group_collapsed = std::map<std::string, bool>();
+bool row_has_key(Model* model, int i, const std::vector<int>& key,
+                 const std::vector<std::string>& key_values) {
+    for (int j = 0; j < key.size(); ++j) {
+        if (model->cell_view(i, key[j]) != key_values[j]) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        for (int i = 0; i < model->rows(); ++i) {
-            auto value = model->cell_text(i, j);
-            auto lookup = previous_group_collapsed.find(value);
-            if (lookup == previous_group_collapsed.end()) {
-                next_group_collapsed.insert(std::make_pair(value, false));
-            } else {
-                next_group_collapsed.insert(std::make_pair(value, lookup->second));
+void refresh_column_values(State* state, int j) {
+    if (!state->column_values_stale[j]) {
+        return;
+    }
+    state->column_values[j] = build_column_values(state->source, j);
+    state->column_values_stale[j] = false;
+}
+
+void apply_model_delta(State* state, const ModelDelta& delta) {
+    auto model = state->source;
+    auto& settings = state->settings;
+    auto num_cols = model->columns();
+    auto num_rows = model->rows();
+    auto first_appended = num_rows - delta.appended_rows;
+
+    // Row numbers held in the state refer to the model before the
+    // delta, so renumber them first
+    if (!delta.removed_rows.empty()) {
+        remap_removed_rows(state, delta);
+    }
+
+    // The values that updates replaced or removed rows held may no longer
+    // exist anywhere, so those columns are rebuilt when the filter overlay
+    // next needs them. Until then their values are dropped rather than
+    // added to, which would grow them without bound on a table that
+    // keeps evicting rows. Other columns take in the appended values.
+    auto all_stale = (!delta.updated_rows.empty() || !delta.removed_rows.empty());
+    for (auto& cell : delta.updated_cells) {
+        state->column_values_stale[cell.second] = true;
+    }
+    for (int j = 0; j < num_cols; ++j) {
+        auto& values = state->column_values[j];
+        if (all_stale) {
+            state->column_values_stale[j] = true;
+        }
+        if (state->column_values_stale[j]) {
+            if (!values.empty()) {
+                values = ValueMap();
             }
+            continue;
+        }
+        for (int i = first_appended; i < num_rows; ++i) {
+            insert_value(values, model->cell_view(i, j));
         }
+    }
 
-        settings.group_collapsed = std::move(next_group_collapsed);
+    if (state->filter_overlay.active_column != -1) {
+        state->filter_overlay.value_list = prepare_filter_value_list(state, state->filter_overlay.active_column);
+    }
+
+    refresh_selection(state);
+
+    // Results are kept up to date by merging in the changed rows, which
+    // also keeps the ResultsCache in step with them, unless too much
+    // changed
+    if (update_results_from_delta(*model, settings, state->results_cache, state->results,
+                                  state->private_copy_ref, delta)) {
+        update_results_layout(state);
+    } else {
+        refresh_results(state);
+    }
+}
 
+void remap_removed_rows(State* state, const ModelDelta& delta) {
+    // Removal keeps the remaining rows in order, so an edit in progress
+    // on a removed row is dropped rather than written to another row
+    if (state->editable_field.is_open) {
+        auto row = map_row_through_delta(delta, state->editable_field.row);
+        if (row == -1) {
+            state->editable_field.is_open = false;
+        } else {
+            state->editable_field.row = row;
+        }
+    }
+
+    // A keyed selection whose row was removed is looked up by its key
+    // in refresh_selection, in case the row was re-added
+    if (state->selection.row != -1) {
+        auto row = map_row_through_delta(delta, state->selection.row);
+        if (row != -1) {
+            state->selection.row = row;
+        } else if (state->source->key().empty()) {
+            clear_selection(state);
+        }
     }
+}
+
+void refresh_results(State* state) {
+    auto model = state->source;
+    auto& settings = state->settings;
 
     // (Re)apply the settings
-    state->results = apply_settings(*model, settings);
+    update_results(*model, settings, state->results_cache, state->results);
+
+    update_results_layout(state);
+}
+
+void update_results_layout(State* state) {
 
     // Compute dimensions for scroll area
     state->content_width = calculate_table_width(state);
@@ -899,6 +1077,14 @@ void refresh_results(State* state) {
     }
 }
 
+std::vector<bool> dictionary_ids_used(Model* model, int j) {
+    std::vector<bool> ids_used(model->dictionary_size(j));
+    for_each_cell_id(*model, j, [&](int i, uint32_t id) {
+        ids_used[id] = true;
+    });
+    return ids_used;
+}
+
 bool process_settings_change(State* state) {
     auto settings_changed = state->settings_changed;
     state->settings_changed = false;
@@ -915,7 +1101,7 @@ void set_selection(State* state, int i, int j) {
     if (!key.empty()) {
         auto i = state->selection.row;
         for (auto j : key) {
-            state->selection.row_key.push_back(state->source->cell_text(i, j));
+            state->selection.row_key.push_back(std::string(state->source->cell_view(i, j)));
         }
     }
 
@@ -1010,7 +1196,7 @@ void update_editable_field(State* state) {
     {
         auto i = state->editable_field.row;
         auto j = state->editable_field.column;
-        if (state->editable_field.current_cell_text != state->source->cell_text(i, j)) {
+        if (state->editable_field.current_cell_text != state->source->cell_view(i, j)) {
             state->editable_field.is_open = false;
             return;
         }
@@ -1068,7 +1254,7 @@ std::string TableItemArrangerModel::label(int index) {
 }
 bool TableItemArrangerModel::get_enabled(int index) {
     auto j = state->settings.column_ordering[index];
-    if (state->settings.grouped_column == j) {
+    if (group_level(state->settings, j) != -1) {
         return false;
     }
     return state->settings.column_enabled[j];
@@ -1076,8 +1262,10 @@ bool TableItemArrangerModel::get_enabled(int index) {
 void TableItemArrangerModel::set_enabled(int index, bool enable) {
     state->settings_changed = true;
     auto j = state->settings.column_ordering[index];
-    if (state->settings.grouped_column == j) {
-        state->settings.grouped_column = -1;
+    auto level = group_level(state->settings, j);
+    if (level != -1) {
+        auto& grouped_columns = state->settings.grouped_columns;
+        grouped_columns.erase(grouped_columns.begin() + level);
         state->settings.group_collapsed.clear();
     }
     state->settings.column_enabled[j] = enable;
@@ -40,9 +40,12 @@ struct State {
     
     // Private copy of the data
     long private_copy_ref;
+    Model* private_copy_source; // the model private_copy_ref is a ref of
     std::vector<std::string> headers;
-    std::vector<std::map<std::string, bool>> column_values;
+    std::vector<ValueMap> column_values;
+    std::vector<bool> column_values_stale; // may hold values no longer present
     Settings settings;
+    ResultsCache results_cache;
     Results results;
     bool settings_changed;
 
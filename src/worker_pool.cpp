@@ -0,0 +1,132 @@
+//
+//  worker_pool.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "worker_pool.hpp"
+#include <memory>
+
+namespace Table {
+
+static std::unique_ptr<WorkerPool>& shared_pool() {
+    static std::unique_ptr<WorkerPool> pool(new WorkerPool(std::thread::hardware_concurrency()));
+    return pool;
+}
+
+WorkerPool& WorkerPool::shared() {
+    return *shared_pool();
+}
+
+void WorkerPool::set_shared_size(int size) {
+    auto& pool = shared_pool();
+    pool.reset();
+    pool.reset(new WorkerPool(size));
+}
+
+WorkerPool::WorkerPool(int size) {
+    generation = 0;
+    stopping = false;
+    busy_workers = 0;
+    task = NULL;
+    task_count = 0;
+    next_task = 0;
+
+    for (int k = 1; k < size; ++k) {
+        threads.push_back(std::thread([this]() {
+            worker();
+        }));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallel_for(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) {
+        return;
+    }
+    if (threads.empty() || count == 1) {
+        for (int k = 0; k < count; ++k) {
+            fn(k);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> caller_lock(caller_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        task_count = count;
+        next_task = 0;
+        error = nullptr;
+        busy_workers = threads.size();
+        ++generation;
+    }
+    work_ready.notify_all();
+
+    run_tasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this]() {
+        return busy_workers == 0;
+    });
+    task = NULL;
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkerPool::worker() {
+    long seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock, [&]() {
+                return stopping || generation != seen_generation;
+            });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        run_tasks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0) {
+            work_done.notify_one();
+        }
+    }
+}
+
+// Takes tasks off the shared counter until there are none left
+void WorkerPool::run_tasks() {
+    while (true) {
+        auto k = next_task.fetch_add(1);
+        if (k >= task_count) {
+            return;
+        }
+        try {
+            (*task)(k);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+//
+//  worker_pool.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_worker_pool_hpp
+#define ddui_table_worker_pool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Table {
+
+// A fixed set of threads for splitting up work on large tables. The
+// calling thread takes part in the work too, so a pool of size 1 has
+// no threads of its own and runs everything inline.
+class WorkerPool {
+    public:
+        // Shared by all tables, sized to the number of hardware threads
+        static WorkerPool& shared();
+
+        // Replaces the shared pool with one of the given size, to limit
+        // the threads tables use. Not while the shared pool is working.
+        static void set_shared_size(int size);
+
+        WorkerPool(int size);
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        int size() {
+            return threads.size() + 1;
+        }
+
+        // Calls fn(k) for every k in [0, count), spread over the pool,
+        // and returns once all calls are done. If any call throws, the
+        // first exception is rethrown here. Calls from several threads
+        // are run one after another; fn must not call parallel_for.
+        void parallel_for(int count, const std::function<void(int)>& fn);
+
+    private:
+        void worker();
+        void run_tasks();
+
+        std::vector<std::thread> threads;
+        std::mutex caller_mutex; // one parallel_for at a time
+
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+        long generation; // bumped for every parallel_for
+        bool stopping;
+        int busy_workers;
+
+        const std::function<void(int)>* task;
+        int task_count;
+        std::atomic<int> next_task;
+        std::exception_ptr error;
+};
+
+}
+
+#endif
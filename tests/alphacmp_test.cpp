@@ -0,0 +1,87 @@
+//
+//  alphacmp_test.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "test.hpp"
+#include "alphacmp.hpp"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Table;
+
+static int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// Compares two sort keys the way sort_rows does: memcmp over the
+// shorter length, then the shorter key first
+static int compare_keys(const std::string& l, const std::string& r) {
+    auto diff = std::memcmp(l.data(), r.data(), std::min(l.size(), r.size()));
+    if (diff != 0) {
+        return diff;
+    }
+    return (l.size() < r.size() ? -1 : l.size() > r.size() ? 1 : 0);
+}
+
+// Checks that the keys of every pair of values order like alphacmp
+static void check_same_order(const std::vector<std::string>& values) {
+    std::vector<std::string> keys(values.size());
+    for (int i = 0; i < values.size(); ++i) {
+        alphacmp_sort_key(values[i], keys[i]);
+    }
+    for (int i = 0; i < values.size(); ++i) {
+        for (int j = 0; j < values.size(); ++j) {
+            auto expected = sign(alphacmp(values[i], values[j]));
+            auto actual = sign(compare_keys(keys[i], keys[j]));
+            if (actual != expected) {
+                std::fprintf(stderr, "\"%s\" vs \"%s\": alphacmp %d, keys %d\n",
+                             values[i].c_str(), values[j].c_str(), expected, actual);
+            }
+            CHECK(actual == expected);
+        }
+    }
+}
+
+static void test_edge_cases() {
+    check_same_order({
+        "",
+        "a", "b", "A", "Z", " ", "~", "/", ":", "\x01", "\x7f",
+        // Digit runs, with leading zeros and past what fits in 64 bits
+        "0", "00", "7", "007", "0007x", "7x", "10", "9", "255", "256", "65536",
+        "18446744073709551615", "18446744073709551616", "123456789012345678901234567890",
+        "000000000000000000000000000001",
+        // A value that is a prefix of another
+        "abc", "abcd", "ab", "a1", "a10", "a1b", "a 1", "a01", "a1 ",
+        "item 2", "item 10", "item 10a", "item10", "1.5", "1.50", "1.05",
+        // Chars with the high bit set, which alphacmp compares as signed
+        "\x80", "\xff", "\xc3\xa9", "e\xcc\x81", "\xc3\xa9t\xc3\xa9", "a\xff", "a\x80" "1",
+        "9\xff", "\xff" "9"
+    });
+}
+
+static void test_random_values() {
+    static const char chars[] = "0019aZ .\x80\xff";
+    std::mt19937 rng(18);
+    std::vector<std::string> values;
+    for (int i = 0; i < 400; ++i) {
+        std::string value;
+        auto length = rng() % 8;
+        for (int c = 0; c < length; ++c) {
+            value.push_back(chars[rng() % (sizeof(chars) - 1)]);
+        }
+        values.push_back(value);
+    }
+    check_same_order(values);
+}
+
+int main() {
+    test_edge_cases();
+    test_random_values();
+    return 0;
+}
@@ -0,0 +1,227 @@
+//
+//  results_delta_test.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "test.hpp"
+#include "settings.hpp"
+#include "columnar_model.hpp"
+#include "ring_buffer_model.hpp"
+#include <cmath>
+#include <functional>
+#include <random>
+
+using namespace Table;
+
+// Applies random changes to a model and brings the results up to date
+// with update_results_from_delta after each batch, checking them against
+// results computed from scratch. Covers sort keys, groups, aggregates
+// and filters, on models that append, update and remove rows.
+
+static const int NUM_COLUMNS = 6;
+static const int STEPS = 200;
+
+static std::mt19937 rng(25);
+static int next_id = 0;
+
+// Columns: a unique id, two group columns, a number, a string and a
+// small integer that's filtered on. A few rows get a group value that
+// isn't seen before, which forces a regroup.
+static std::vector<std::string> random_row(bool new_groups) {
+    auto group = (new_groups && rng() % 150 == 0 ? "new " + std::to_string(rng()) : std::to_string(rng() % 4));
+    auto number = (rng() % 6 == 0 ? std::string() :
+                   std::to_string((int)(rng() % 200) - 100) + "." + std::to_string(rng() % 10));
+    return {
+        std::to_string(next_id++),
+        group,
+        std::to_string(rng() % 3),
+        number,
+        "s" + std::to_string(rng() % 30),
+        std::to_string(rng() % 100)
+    };
+}
+
+static bool close(double a, double b) {
+    return a == b || std::fabs(a - b) <= 1e-6 * std::max(1.0, std::fabs(a));
+}
+
+static void check_same_results(const Results& actual, const Results& expected) {
+    CHECK(actual.row_indices == expected.row_indices);
+    CHECK(actual.group_headings.size() == expected.group_headings.size());
+    for (size_t k = 0; k < expected.group_headings.size(); ++k) {
+        auto& a = actual.group_headings[k];
+        auto& e = expected.group_headings[k];
+        CHECK(a.key == e.key);
+        CHECK(a.count == e.count);
+        CHECK(a.position == e.position);
+        CHECK(a.aggregates.size() == e.aggregates.size());
+        for (size_t q = 0; q < e.aggregates.size(); ++q) {
+            // Sums drift by rounding as numbers are taken out and put in
+            CHECK(a.aggregates[q].count == e.aggregates[q].count);
+            CHECK(close(a.aggregates[q].sum, e.aggregates[q].sum));
+            CHECK(a.aggregates[q].min == e.aggregates[q].min);
+            CHECK(a.aggregates[q].max == e.aggregates[q].max);
+        }
+    }
+}
+
+static Settings make_settings(int mode) {
+    Settings settings;
+    settings.column_widths.assign(NUM_COLUMNS, 100);
+    settings.column_enabled.assign(NUM_COLUMNS, true);
+    for (int j = 0; j < NUM_COLUMNS; ++j) {
+        settings.column_ordering.push_back(j);
+    }
+    ColumnFilter no_filter;
+    no_filter.enabled = false;
+    settings.filters.assign(NUM_COLUMNS, no_filter);
+    settings.max_delta_churn = 0.5f;
+
+    if (mode >= 2) {
+        settings.sort_keys.push_back(SortKey{3, mode % 3 != 0});
+    }
+    if (mode >= 4) {
+        settings.sort_keys.push_back(SortKey{4, false});
+    }
+    if (mode >= 6) {
+        settings.grouped_columns = {1};
+    }
+    if (mode >= 9) {
+        settings.grouped_columns = {1, 2};
+    }
+    if (mode == 7 || mode == 10 || mode == 11) {
+        settings.aggregated_columns = {3, 5};
+    }
+    if (mode % 4 == 1 || mode == 8 || mode == 11) {
+        settings.filters[5].enabled = true;
+        for (int v = 0; v < 70; ++v) {
+            settings.filters[5].allowed_values[std::to_string(v)] = true;
+        }
+    }
+    return settings;
+}
+
+// Runs STEPS batches of changes, with `change` making one random change
+static void run(Model& model, Settings settings, const std::function<void()>& change) {
+    ResultsCache cache;
+    Results results;
+    update_results(model, settings, cache, results);
+    if (!settings.grouped_columns.empty()) {
+        settings.group_collapsed[cache.groups[1].key] = true;
+        update_results(model, settings, cache, results);
+    }
+
+    auto since_ref = model.ref();
+    for (int step = 0; step < STEPS; ++step) {
+        auto num_changes = 1 + rng() % (step % 10 == 0 ? 40 : 3);
+        for (int k = 0; k < num_changes; ++k) {
+            change();
+        }
+
+        ModelDelta delta;
+        CHECK(model.delta(since_ref, &delta));
+        if (!update_results_from_delta(model, settings, cache, results, since_ref, delta)) {
+            update_results(model, settings, cache, results);
+        }
+        since_ref = model.ref();
+
+        Settings fresh_settings = settings;
+        ResultsCache fresh_cache;
+        Results fresh_results;
+        update_results(model, fresh_settings, fresh_cache, fresh_results);
+        check_same_results(results, fresh_results);
+    }
+}
+
+static std::vector<std::string> headers() {
+    return {"id", "group", "subgroup", "number", "string", "filtered"};
+}
+
+static void update_random_cell(Model& model) {
+    auto row = random_row(true);
+    auto j = 1 + rng() % (NUM_COLUMNS - 1);
+    model.set_cell_text(rng() % model.rows(), j, row[j]);
+}
+
+// Appends and updates, with typed number columns in odd modes
+static void test_columnar(int mode) {
+    ColumnarModel model(headers(), {"id"});
+    for (int i = 0; i < 3000; ++i) {
+        model.insert_row(random_row(false));
+    }
+    if (mode % 2 == 1) {
+        model.set_column_type(3, Model::COLUMN_DOUBLE);
+        model.set_column_type(5, Model::COLUMN_INT64);
+    }
+    run(model, make_settings(mode), [&]() {
+        if (rng() % 3 == 0) {
+            model.insert_row(random_row(true));
+        } else {
+            update_random_cell(model);
+        }
+    });
+}
+
+// Each append past the capacity removes the oldest row
+static void test_ring_buffer(int mode) {
+    RingBufferModel model(headers(), {}, 2000);
+    model.editable = true;
+    for (int i = 0; i < 3000; ++i) {
+        model.insert_row(random_row(false));
+    }
+    run(model, make_settings(mode), [&]() {
+        if (rng() % 2 == 0) {
+            model.insert_row(random_row(true));
+        } else {
+            update_random_cell(model);
+        }
+    });
+}
+
+// Reconciling removes rows from anywhere in the table
+static void test_reconcile(int mode) {
+    BasicModel model(headers(), {"id"});
+    model.editable = true;
+    for (int i = 0; i < 3000; ++i) {
+        model.insert_row(random_row(false));
+    }
+    run(model, make_settings(mode), [&]() {
+        auto kind = rng() % 3;
+        if (kind == 0) {
+            model.insert_row(random_row(true));
+        } else if (kind == 1) {
+            update_random_cell(model);
+        } else {
+            std::vector<std::vector<std::string>> rows;
+            for (int i = 0; i < model.rows(); ++i) {
+                if (rng() % 200 == 0) {
+                    continue;
+                }
+                std::vector<std::string> row;
+                for (int j = 0; j < NUM_COLUMNS; ++j) {
+                    row.push_back(model.cell_text(i, j));
+                }
+                if (rng() % 300 == 0) {
+                    row[3] = random_row(true)[3];
+                }
+                rows.push_back(std::move(row));
+            }
+            for (int k = rng() % 3; k > 0; --k) {
+                rows.push_back(random_row(true));
+            }
+            model.reconcile(std::move(rows));
+        }
+    });
+}
+
+int main() {
+    for (int mode = 0; mode < 12; ++mode) {
+        test_columnar(mode);
+        test_ring_buffer(mode);
+        test_reconcile(mode);
+    }
+    return 0;
+}
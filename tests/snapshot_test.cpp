@@ -0,0 +1,157 @@
+//
+//  snapshot_test.cpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#include "test.hpp"
+#include "snapshot_model.hpp"
+#include "columnar_model.hpp"
+#include "typed_value.hpp"
+#include <cmath>
+
+using namespace Table;
+
+static const char* PATH = "snapshot_test.snap";
+
+// Checks that `actual` holds the same headers, key and cells as
+// `expected`, through every way of reading a cell
+static void check_same_cells(Model& expected, Model& actual) {
+    CHECK(actual.rows() == expected.rows());
+    CHECK(actual.columns() == expected.columns());
+    CHECK(actual.key() == expected.key());
+
+    std::vector<std::string_view> cells(expected.rows());
+    for (int col = 0; col < expected.columns(); ++col) {
+        CHECK(actual.header_text(col) == expected.header_text(col));
+        if (expected.rows() > 0) {
+            actual.cells(col, 0, expected.rows(), cells.data());
+        }
+        for (int row = 0; row < expected.rows(); ++row) {
+            auto& text = expected.cell_text(row, col);
+            CHECK(actual.cell_text(row, col) == text);
+            CHECK(actual.cell_view(row, col) == text);
+            CHECK(cells[row] == text);
+        }
+    }
+}
+
+// Checks the typed values and dictionaries of `actual` against the
+// model the snapshot was saved from
+static void check_same_values(Model& expected, Model& actual) {
+    for (int col = 0; col < expected.columns(); ++col) {
+        auto type = expected.column_type(col);
+        CHECK(actual.column_type(col) == type);
+        CHECK(actual.column_has_dictionary(col) == expected.column_has_dictionary(col));
+
+        for (int row = 0; row < expected.rows(); ++row) {
+            if (type == Model::COLUMN_DOUBLE) {
+                auto a = expected.cell_double(row, col);
+                auto b = actual.cell_double(row, col);
+                CHECK(a == b || (std::isnan(a) && std::isnan(b)));
+            } else if (type != Model::COLUMN_STRING) {
+                CHECK(actual.cell_int64(row, col) == expected.cell_int64(row, col));
+            }
+            if (expected.column_has_dictionary(col)) {
+                auto id = actual.cell_id(row, col);
+                CHECK(actual.dictionary_text(col, id) ==
+                      expected.dictionary_text(col, expected.cell_id(row, col)));
+            }
+        }
+    }
+}
+
+static void test_empty() {
+    BasicModel model({"a", "b"}, {"a"});
+    save_table_snapshot(model, PATH);
+    SnapshotModel snapshot(PATH);
+    snapshot.verify();
+    check_same_cells(model, snapshot);
+}
+
+static void test_string_columns() {
+    BasicModel model({"id", "name", "x,\"y\"\n"}, {"id"});
+    for (int i = 0; i < 5000; ++i) {
+        model.insert_row({
+            std::to_string(i),
+            "n\n\"a" + std::string(i % 7, 'z'),
+            i % 3 ? "" : "v"
+        });
+    }
+    save_table_snapshot(model, PATH);
+    SnapshotModel snapshot(PATH);
+    snapshot.verify();
+    check_same_cells(model, snapshot);
+    check_same_values(model, snapshot);
+}
+
+static void test_dictionary_columns() {
+    std::vector<std::string> headers = {"id", "category", "tag"};
+    BasicModel basic(headers, {"id"});
+    ColumnarModel columnar(headers, {"id"});
+    for (int i = 0; i < 20000; ++i) {
+        std::vector<std::string> row = {
+            std::to_string(i),
+            "category " + std::to_string(i % 13),
+            i % 4 ? "" : "tag" + std::to_string(i % 3)
+        };
+        basic.insert_row(row);
+        columnar.insert_row(row);
+    }
+    columnar.set_column_dictionary(1, true);
+    columnar.set_column_dictionary(2, true);
+
+    save_table_snapshot(columnar, PATH);
+    SnapshotModel snapshot(PATH);
+    snapshot.verify();
+    check_same_cells(basic, snapshot);
+    check_same_values(columnar, snapshot);
+}
+
+static void test_typed_columns() {
+    std::vector<std::string> headers = {"id", "price", "time", "note"};
+    BasicModel basic(headers, {"id"});
+    ColumnarModel columnar(headers, {"id"});
+
+    // The typed cells are given in their formatted form so that the
+    // typed columns read back the same text as the string ones
+    std::string price, time;
+    for (int i = 0; i < 20000; ++i) {
+        price.clear();
+        if (i % 11 != 0) {
+            format_double(i * 0.25 - 100, price);
+        }
+        time.clear();
+        if (i % 5 != 0) {
+            format_timestamp(1791201600000000LL + i * 1000500LL, time);
+        }
+        std::vector<std::string> row = {
+            std::to_string(i * 7 - 1000),
+            price,
+            time,
+            "note " + std::to_string(i)
+        };
+        basic.insert_row(row);
+        columnar.insert_row(row);
+    }
+    columnar.set_column_type(0, Model::COLUMN_INT64);
+    columnar.set_column_type(1, Model::COLUMN_DOUBLE);
+    columnar.set_column_type(2, Model::COLUMN_TIMESTAMP);
+
+    save_table_snapshot(columnar, PATH);
+    SnapshotModel snapshot(PATH);
+    snapshot.verify();
+    check_same_cells(basic, snapshot);
+    check_same_values(columnar, snapshot);
+}
+
+int main() {
+    test_empty();
+    test_string_columns();
+    test_dictionary_columns();
+    test_typed_columns();
+    std::remove(PATH);
+    return 0;
+}
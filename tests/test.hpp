@@ -0,0 +1,24 @@
+//
+//  test.hpp
+//  ddui-table
+//
+//  Created by agent on 17/10/2026.
+//  Copyright © 2026 agent All rights reserved.
+//
+
+#ifndef ddui_table_test_hpp
+#define ddui_table_test_hpp
+
+#include <cstdio>
+#include <cstdlib>
+
+// Fails the test with the location of the check that didn't hold
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+#endif